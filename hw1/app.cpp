@@ -97,17 +97,7 @@ bool test_overlap(Factory *factory, Station *s)
 	bool result = false;
 	if(x0 < x1 && y0 < y1 && test_bounds(x0, y0, x1, y1))
 	{
-		for(int map_x = x0; map_x < x1; ++map_x)
-		{
-			for(int map_y = y0; map_y < y1; ++map_y)
-			{
-				if(factory->map[map_y * MAP_W + map_x] == 1)
-				{
-					result = true;
-					break;
-				}
-			}
-		}
+		result = occupancy_test_rect(&factory->map, x0, y0, x1, y1);
 	}else
 	{
 		result = true;
@@ -127,15 +117,27 @@ bool test_overlap(Factory *factory, int x, int y, int w, int h)
 	return result;
 }
 
+// Zobrist key of a placed station. The rectangle alone is enough, every station type has its own size. The keys are
+// computed with a splitmix64 finalizer instead of looked up in a table of random numbers
+uint64_t get_station_hash(Station *s)
+{
+	uint64_t result = ((uint64_t)(uint16_t)s->x0 << 48) | ((uint64_t)(uint16_t)s->y0 << 32) | ((uint64_t)(uint16_t)s->x1 << 16) | (uint64_t)(uint16_t)s->y1;
+
+	result += 0x9E3779B97F4A7C15ull;
+	result  = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ull;
+	result  = (result ^ (result >> 27)) * 0x94D049BB133111EBull;
+	result  = result ^ (result >> 31);
+
+	return result;
+}
+
+// Writes and erases both toggle the station's key, callers only erase placed stations and only write free ones
 void write_to_map(Factory *factory, Station *s, int val)
 {
-	for(int map_x = s->x0; map_x < s->x1; ++map_x)
-	{
-		for(int map_y = s->y0; map_y < s->y1; ++map_y)
-		{
-			factory->map[map_y * MAP_W + map_x] = val;
-		}
-	}
+	occupancy_write_rect(&factory->map, s->x0, s->y0, s->x1, s->y1, val != 0);
+
+	hpa_add_touched_clusters(&factory->dirty_clusters, s->x0, s->y0, s->x1, s->y1);
+	factory->hash ^= get_station_hash(s);
 }
 
 void write_to_map(Factory *factory, int x, int y, int w, int h, int val)
@@ -149,7 +151,7 @@ void write_to_map(Factory *factory, int x, int y, int w, int h, int val)
 	write_to_map(factory, &s, val);
 }
 
-Factory generate_factory(AppState *app, Arena *arena)
+Factory generate_factory(AppState *app, unsigned int *rng_seed)
 {
 	Factory result  = {};
 #if 0
@@ -157,6 +159,17 @@ Factory generate_factory(AppState *app, Arena *arena)
 	result.stations = arena_push_array(arena, DESIRED_STATION_COUNT, Station);
 #endif
 
+	// Padded corners where each station type still fits, so that one draw always lands on a free spot. A write only
+	// rules out the corners whose padded rectangle overlaps it, the bitmaps are built once and shrink from there
+	TmpArena scratch   = arena_begin_scratch(NULL, 0);
+	MapBits *positions = arena_push_array(scratch.arena, STATION_TYPE_COUNT, MapBits);
+
+	for(int type_idx = 0; type_idx < STATION_TYPE_COUNT; ++type_idx)
+	{
+		StationType type = app->station_types[type_idx];
+		occupancy_get_free_positions(&positions[type_idx], &result.map, type.w + 2, type.h + 2);
+	}
+
 	for(int station_idx = 0; station_idx < DESIRED_STATION_COUNT; ++station_idx)
 	{
 		int         type_idx = station_idx % STATION_TYPE_COUNT;
@@ -170,27 +183,22 @@ Factory generate_factory(AppState *app, Arena *arena)
 
 		if(bound_x > 0 && bound_y > 0)
 		{
-			int x = 0;
-			int y = 0;
+			// Corners below the bounds keep the station in the 1 to bound_x range the random tries used to draw from
+			PathTile corner   = {};
+			bool     is_found = map_bits_pick_position(&positions[type_idx], bound_x, bound_y, random(rng_seed), &corner);
 
-			int max_tries = 128;
-			int try_count = 0;
-regenerate_facility:
-			if(try_count++ < max_tries)
+			if(is_found)
 			{
-				// Account for door placement
-				x = (random(&app->rng_seed) % bound_x) + 1;
-				y = (random(&app->rng_seed) % bound_y) + 1;
+				int x = corner.x + 1;
+				int y = corner.y + 1;
+
+				write_to_map(&result, x, y, w, h, 1);
 
-				if(test_overlap(&result, x, y, w, h))
+				for(int other_type_idx = 0; other_type_idx < STATION_TYPE_COUNT; ++other_type_idx)
 				{
-					goto regenerate_facility;
+					StationType other_type = app->station_types[other_type_idx];
+					map_bits_clear_rect(&positions[other_type_idx], x - other_type.w - 1, y - other_type.h - 1, x + w, y + h);
 				}
-			}
-
-			if(try_count < max_tries)
-			{
-				write_to_map(&result, x, y, w, h, 1);
 
 				Station *station = &result.stations[result.station_count++];
 				StationType type = app->station_types[type_idx];
@@ -213,6 +221,8 @@ regenerate_facility:
 		}
 	}
 
+	arena_end_scratch(scratch);
+
 	return result;
 }
 
@@ -273,67 +283,1569 @@ void merge_sort_factories(Factory *sorted, Factory *unsorted, int count)
 	memcpy(unsorted, sorted, count * sizeof(Factory));
 }
 
-int get_fitness_score(AppState *app, Factory *factory)
+int get_fitness_step_count(AppState *app)
+{
+	int result = MAX_STEP_COUNT;
+	if(app->step_count > 0)
+	{
+		result = app->step_count;
+	}
+	return result;
+}
+
+void get_factory_doors(Factory *factory, PathTile *doors)
+{
+	for(int i = 0; i < factory->station_count; ++i)
+	{
+		Station *station = &factory->stations[i];
+
+		PathTile *door = &doors[i];
+
+		door->x = station->x0 + station->door_offset_x;
+		door->y = station->y0 + station->door_offset_y;
+	}
+}
+
+void get_factory_rects(Factory *factory, MapRect *rects)
+{
+	for(int i = 0; i < factory->station_count; ++i)
+	{
+		Station *station = &factory->stations[i];
+
+		rects[i] = {station->x0, station->y0, station->x1, station->y1};
+	}
+}
+
+// distances is the door matrix from path_find_door_distances
+int get_fitness_score_from_distances(AppState *app, Factory *factory, int *distances)
 {
 	int result = 1000000;
 
+	int door_count = factory->station_count;
+	for(int station_idx = 0; station_idx < door_count; ++station_idx)
+	{
+		Station *station = &factory->stations[station_idx];
+
+		for(int target_idx = station_idx + 1; target_idx < door_count; ++target_idx)
+		{
+			Station *target_station = &factory->stations[target_idx];
+
+			int weight = app->station_weight_lut[station->type][target_station->type];
+
+			result -= distances[station_idx * door_count + target_idx] * weight;
+		}
+	}
+
+	return result;
+}
+
+bool path_find_mode_has_cutoff(PathFindMode mode)
+{
+	// Modes with exact depth-limited distances, a pair within reach never scores under its Manhattan bound. A* and JPS
+	// stop after max_step_count expansions and report whatever partial path they gave up on, under or over the bound
+	bool result = mode == PATH_FIND_MODE_FLOOD || mode == PATH_FIND_MODE_BITS;
+	return result;
+}
+
+// Branch and bound version of get_fitness_score. One search per source door replaces the pairs' Manhattan bounds with
+// found distances, and the source with the heaviest weighted bounds left goes first. The factory is given up on once the
+// score with the bounds left falls below cutoff_score, and that score is returned. Pairs beyond the step count score 0
+// without a search. Any other pair may still be walled in and score 0, so its bound only counts once one search reached
+// both of its doors within the step count between them, which puts the pair within reach too. Unless pruned, distances
+// (door_count * door_count, can be NULL) gets the FoundPath::tile_count of every pair in both triangles and footprints
+// (can be NULL) the upper triangle of path_find_target_distances' footprints. is_known (can be NULL) marks the pairs of
+// the upper triangle whose distances entry is already exact, those are scored from it without a search
+int get_fitness_score_bounded(AppState *app, Factory *factory, PathFindOptions *options, int cutoff_score, bool *is_pruned, int *distances, PathFootprint *footprints, bool *is_known)
+{
 	TmpArena scratch = arena_begin_scratch(NULL, 0);
 
-	int       target_count = factory->station_count;
-	PathTile *targets      = arena_push_array(scratch.arena, target_count, PathTile);
+	int door_count = factory->station_count;
+	int step_count = get_fitness_step_count(app);
 
-	assert(target_count <= factory->station_count);
-	for(int i = 0; i < target_count; ++i)
+	PathTile *doors       = arena_push_array(scratch.arena, door_count, PathTile);
+	int      *weights     = arena_push_array(scratch.arena, door_count * door_count, int);
+	int      *bounds      = arena_push_array(scratch.arena, door_count * door_count, int);
+	bool     *is_proven   = arena_push_array(scratch.arena, door_count * door_count, bool); // The bound counts in the score
+	int      *row_bounds  = arena_push_array(scratch.arena, door_count, int); // Weighted bounds of the pairs left per door
+	bool     *is_searched = arena_push_array(scratch.arena, door_count, bool);
+	get_factory_doors(factory, doors);
+
+	PathTile *targets     = arena_push_array(scratch.arena, door_count, PathTile);
+	int      *target_idxs = arena_push_array(scratch.arena, door_count, int);
+	int      *tile_counts = arena_push_array(scratch.arena, door_count, int);
+
+	PathFootprint *target_footprints = footprints ? arena_push_array(scratch.arena, door_count, PathFootprint) : NULL;
+
+	int result = 1000000;
+
+	for(int station_idx = 0; station_idx < door_count; ++station_idx)
 	{
-		Station *station = &factory->stations[i];
+		for(int target_idx = station_idx + 1; target_idx < door_count; ++target_idx)
+		{
+			int step_bound = abs(doors[station_idx].x - doors[target_idx].x) + abs(doors[station_idx].y - doors[target_idx].y);
+			int bound      = step_bound <= step_count ? step_bound + 1 : 0;
+			int weight     = app->station_weight_lut[factory->stations[station_idx].type][factory->stations[target_idx].type];
 
-		PathTile *target = &targets[i];
+			// A known pair is never searched, it counts like a proven bound
+			if(is_known && is_known[station_idx * door_count + target_idx])
+			{
+				result -= weight * distances[station_idx * door_count + target_idx];
+				bound   = 0;
+			}
 
-		target->x = station->x0 + station->door_offset_x;
-		target->y = station->y0 + station->door_offset_y;
+			weights[station_idx * door_count + target_idx] = weight;
+			weights[target_idx * door_count + station_idx] = weight;
+			bounds [station_idx * door_count + target_idx] = bound;
+			bounds [target_idx * door_count + station_idx] = bound;
+
+			row_bounds[station_idx] += weight * bound;
+			row_bounds[target_idx]  += weight * bound;
+		}
 	}
 
-	for(int station_idx = 0; station_idx < factory->station_count; ++station_idx)
+	bool is_done = result < cutoff_score;
+	while(!is_done)
 	{
-		Station *station = &factory->stations[station_idx];
+		int source_idx = -1;
+		for(int station_idx = 0; station_idx < door_count; ++station_idx)
+		{
+			if(!is_searched[station_idx] && row_bounds[station_idx] > 0 && (source_idx < 0 || row_bounds[station_idx] > row_bounds[source_idx]))
+			{
+				source_idx = station_idx;
+			}
+		}
 
-		int start_x = station->x0 + station->door_offset_x;
-		int start_y = station->y0 + station->door_offset_y;
+		if(source_idx >= 0)
+		{
+			int target_count = 0;
+			for(int target_idx = 0; target_idx < door_count; ++target_idx)
+			{
+				if(target_idx != source_idx && !is_searched[target_idx] && bounds[source_idx * door_count + target_idx] > 0)
+				{
+					targets    [target_count]   = doors[target_idx];
+					target_idxs[target_count++] = target_idx;
+				}
+			}
 
-		int step_count = MAX_STEP_COUNT;
-		if(app->step_count > 0)
+			path_find_target_distances(&factory->map, doors[source_idx].x, doors[source_idx].y, targets, target_count, step_count, tile_counts, options, target_footprints);
+
+			for(int i = 0; i < target_count; ++i)
+			{
+				int pair_idx = source_idx * door_count + target_idxs[i];
+				int weight   = weights[pair_idx];
+				int bound    = bounds [pair_idx];
+
+				row_bounds[target_idxs[i]] -= weight * bound;
+				result                     -= weight * (tile_counts[i] - (is_proven[pair_idx] ? bound : 0));
+
+				if(distances)
+				{
+					distances[pair_idx]                                 = tile_counts[i];
+					distances[target_idxs[i] * door_count + source_idx] = tile_counts[i];
+				}
+
+				if(footprints)
+				{
+					footprints[min(source_idx, target_idxs[i]) * door_count + max(source_idx, target_idxs[i])] = target_footprints[i];
+				}
+			}
+
+			// A path through the source joins two reached doors in at most the sum of their steps
+			for(int i = 0; i < target_count; ++i)
+			{
+				for(int j = i + 1; j < target_count; ++j)
+				{
+					int pair_idx = target_idxs[i] * door_count + target_idxs[j];
+					if(!is_proven[pair_idx] && bounds[pair_idx] > 0 && tile_counts[i] > 0 && tile_counts[j] > 0 && (tile_counts[i] - 1) + (tile_counts[j] - 1) <= step_count)
+					{
+						is_proven[pair_idx]                                     = true;
+						is_proven[target_idxs[j] * door_count + target_idxs[i]] = true;
+
+						result -= weights[pair_idx] * bounds[pair_idx];
+					}
+				}
+			}
+
+			is_searched[source_idx] = true;
+			row_bounds [source_idx] = 0;
+
+			is_done = result < cutoff_score;
+		}else
 		{
-			step_count = app->step_count;
+			is_done = true;
 		}
+	}
 
-		int target_offset = station_idx + 1;
-		FoundPaths paths  = path_find_targets(factory->map, start_x, start_y, targets + target_offset, target_count - target_offset, step_count, scratch.arena);
+	// Without a source left every pair has its found distance and the score is exact
+	*is_pruned = result < cutoff_score;
 
-		for(int path_idx = 0; path_idx < paths.count; ++path_idx)
+	arena_end_scratch(scratch);
+
+	return result;
+}
+
+// A cutoff_score only applies to the modes path_find_mode_has_cutoff lists, see get_fitness_score_bounded
+int get_fitness_score(AppState *app, Factory *factory, PathFindOptions *options, int cutoff_score, bool *is_pruned)
+{
+	bool is_bounded_pruned = false;
+
+	int result = 0;
+	if(cutoff_score > INT_MIN && options && path_find_mode_has_cutoff(options->mode))
+	{
+		result = get_fitness_score_bounded(app, factory, options, cutoff_score, &is_bounded_pruned, NULL, NULL, NULL);
+	}else
+	{
+		TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+		int       door_count = factory->station_count;
+		PathTile *doors      = arena_push_array(scratch.arena, door_count, PathTile);
+		int      *distances  = arena_push_array(scratch.arena, door_count * door_count, int);
+
+		get_factory_doors(factory, doors);
+
+		if(options && options->mode == PATH_FIND_MODE_VISIBILITY)
 		{
-			FoundPath *path = &paths.paths[path_idx];
+			// The per-thread graph last saw whichever factory this thread evaluated before, often a close relative
+			VisibilityGraph *graph = grid_node_pool_get()->visibility_graph;
+			MapRect         *rects = arena_push_array(scratch.arena, door_count, MapRect);
+
+			get_factory_rects(factory, rects);
+
+			visibility_graph_update  (graph, &factory->map, rects, doors, door_count, options->stats);
+			visibility_door_distances(graph, get_fitness_step_count(app), distances, options->stats);
+		}else
+		{
+			path_find_door_distances(&factory->map, doors, door_count, get_fitness_step_count(app), distances, options);
+		}
+
+		result = get_fitness_score_from_distances(app, factory, distances);
+
+		arena_end_scratch(scratch);
+	}
+
+	if(is_pruned)
+	{
+		*is_pruned = is_bounded_pruned;
+	}
+
+	return result;
+}
+
+bool path_find_mode_has_delta(PathFindMode mode)
+{
+	bool result = mode == PATH_FIND_MODE_FLOOD || mode == PATH_FIND_MODE_BITS || mode == PATH_FIND_MODE_MULTI;
+	return result;
+}
+
+// Row-major index of the pair (station_idx, target_idx) in the upper triangle, station_idx < target_idx
+int get_door_pair_idx(int station_idx, int target_idx)
+{
+	int result = station_idx * (2 * DESIRED_STATION_COUNT - station_idx - 1) / 2 + (target_idx - station_idx - 1);
+	return result;
+}
+
+// Lowest |a - p| + |p - b| along one axis for p in [lo, hi)
+int get_axis_detour(int a, int b, int lo, int hi)
+{
+	int min_coord = min(a, b);
+	int max_coord = max(a, b);
+	int gap       = max(lo - max_coord, 0) + max(min_coord - (hi - 1), 0);
+
+	int result = max_coord - min_coord + 2 * gap;
+	return result;
+}
+
+// Same score as get_fitness_score for the modes with exact depth-limited distances (flood and the bitset modes), but
+// only the pairs a change could have affected are searched again. Filling a rectangle can only lengthen a pair whose
+// stored path it blocks, so it is tested against the path's footprint. Without one, a path of d steps from a to b only
+// visits tiles p with |a - p| + |p - b| <= d and the rectangle has to reach into that region. Vacating a rectangle can
+// only shorten a pair through it, and on a grid by at least 2 steps, so it has to reach into the region for d - 2.
+// Pairs of moved stations, pairs such a rectangle reaches and pairs that were out of reach are searched again, grouped
+// by door. With a cutoff_score they go through get_fitness_score_bounded instead, so that a delta evaluation can be
+// pruned too. old_pairs can be NULL, pairs receives the distances unless the factory was pruned.
+int pair_distances_update(AppState *app, Factory *factory, PairDistances *old_pairs, PairDistances *pairs, PathFindOptions *options, FitnessDeltaStats *stats, int cutoff_score, bool *is_pruned)
+{
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	int door_count = factory->station_count;
+	int step_count = get_fitness_step_count(app);
+
+	PathTile      *doors      = arena_push_array(scratch.arena, door_count, PathTile);
+	MapRect       *rects      = arena_push_array(scratch.arena, door_count, MapRect);
+	int           *distances  = arena_push_array(scratch.arena, door_count * door_count, int);
+	PathFootprint *footprints = arena_push_array(scratch.arena, door_count * door_count, PathFootprint);
+	get_factory_doors(factory, doors);
+	get_factory_rects(factory, rects);
+
+	// Old and new rectangles of the stations that moved since the stored distances were found, in that order
+	bool    *is_station_moved   = arena_push_array(scratch.arena, door_count, bool);
+	MapRect *changed_rects      = arena_push_array(scratch.arena, 2 * door_count, MapRect);
+	int      changed_rect_count = 0;
+
+	bool is_full = !old_pairs || old_pairs->station_count != door_count || old_pairs->step_count != step_count;
+	if(!is_full)
+	{
+		for(int station_idx = 0; station_idx < door_count; ++station_idx)
+		{
+			MapRect *old_rect = &old_pairs->rects[station_idx];
+			MapRect *new_rect = &rects[station_idx];
+
+			if(old_rect->x0 != new_rect->x0 || old_rect->y0 != new_rect->y0 || old_rect->x1 != new_rect->x1 || old_rect->y1 != new_rect->y1)
+			{
+				is_station_moved[station_idx] = true;
+
+				changed_rects[changed_rect_count++] = *old_rect;
+				changed_rects[changed_rect_count++] = *new_rect;
+			}
+		}
+	}
+
+	// Targets to search again by source door. A moved station is the source of its own pairs so that it costs one search
+	int  *target_idxs   = arena_push_array(scratch.arena, door_count * door_count, int);
+	int  *target_counts = arena_push_array(scratch.arena, door_count, int);
+	bool *is_kept       = arena_push_array(scratch.arena, door_count * door_count, bool); // Upper triangle
+
+	bool is_bounded = cutoff_score > INT_MIN && path_find_mode_has_cutoff(options->mode);
+
+	int searched_pair_count = 0;
+	if(!is_full)
+	{
+		for(int station_idx = 0; station_idx < door_count; ++station_idx)
+		{
+			for(int target_idx = station_idx + 1; target_idx < door_count; ++target_idx)
+			{
+				int            distance  = old_pairs->distances [get_door_pair_idx(station_idx, target_idx)];
+				PathFootprint *footprint = &old_pairs->footprints[get_door_pair_idx(station_idx, target_idx)];
+
+				bool is_stale = is_station_moved[station_idx] || is_station_moved[target_idx] || (distance == 0 && changed_rect_count > 0);
+				for(int rect_idx = 0; rect_idx < changed_rect_count && !is_stale; ++rect_idx)
+				{
+					MapRect  *rect   = &changed_rects[rect_idx];
+					PathTile *start  = &doors[station_idx];
+					PathTile *target = &doors[target_idx];
+
+					int detour = get_axis_detour(start->x, target->x, rect->x0, rect->x1) + get_axis_detour(start->y, target->y, rect->y0, rect->y1);
+					if(rect_idx % 2 == 0)
+					{
+						is_stale = detour <= distance - 3;
+					}else if(footprint->box_count > 0)
+					{
+						is_stale = path_footprint_test_rect(footprint, rect->x0, rect->y0, rect->x1, rect->y1);
+					}else
+					{
+						is_stale = detour <= distance - 1;
+					}
+				}
+
+				if(is_stale)
+				{
+					int source_idx = station_idx;
+					int other_idx  = target_idx;
+					if(is_station_moved[target_idx] && !is_station_moved[station_idx])
+					{
+						source_idx = target_idx;
+						other_idx  = station_idx;
+					}
+
+					target_idxs[source_idx * door_count + target_counts[source_idx]++] = other_idx;
+					searched_pair_count++;
+				}else
+				{
+					distances [station_idx * door_count + target_idx] = distance;
+					footprints[station_idx * door_count + target_idx] = *footprint;
+					is_kept   [station_idx * door_count + target_idx] = true;
+				}
+			}
+		}
+
+		// One source search costs about as much as one row of the full door matrix. The bounded search only picks
+		// the sources it needs
+		int source_count = 0;
+		for(int station_idx = 0; station_idx < door_count; ++station_idx)
+		{
+			source_count += target_counts[station_idx] > 0;
+		}
+		is_full = !is_bounded && source_count >= door_count - 1;
+	}
+
+	if(is_full)
+	{
+		searched_pair_count = door_count * (door_count - 1) / 2;
+		stats->full_eval_count++;
+	}
+
+	bool is_bounded_pruned = false;
+	int  bounded_score     = 0;
+	if(is_bounded)
+	{
+		bounded_score = get_fitness_score_bounded(app, factory, options, cutoff_score, &is_bounded_pruned, distances, footprints, is_kept);
+	}else if(is_full)
+	{
+		path_find_door_distances(&factory->map, doors, door_count, step_count, distances, options, footprints);
+	}else
+	{
+		PathTile      *targets           = arena_push_array(scratch.arena, door_count, PathTile);
+		int           *tile_counts       = arena_push_array(scratch.arena, door_count, int);
+		PathFootprint *target_footprints = arena_push_array(scratch.arena, door_count, PathFootprint);
+
+		for(int source_idx = 0; source_idx < door_count; ++source_idx)
+		{
+			int  target_count       = target_counts[source_idx];
+			int *source_target_idxs = &target_idxs[source_idx * door_count];
+
+			if(target_count > 0)
+			{
+				for(int i = 0; i < target_count; ++i)
+				{
+					targets[i] = doors[source_target_idxs[i]];
+				}
+
+				path_find_target_distances(&factory->map, doors[source_idx].x, doors[source_idx].y, targets, target_count, step_count, tile_counts, options, target_footprints);
+
+				for(int i = 0; i < target_count; ++i)
+				{
+					int other_idx = source_target_idxs[i];
+					int pair_idx  = min(source_idx, other_idx) * door_count + max(source_idx, other_idx);
+
+					distances [pair_idx] = tile_counts[i];
+					footprints[pair_idx] = target_footprints[i];
+				}
+			}
+		}
+	}
+
+	stats->pair_count          += door_count * (door_count - 1) / 2;
+	stats->searched_pair_count += searched_pair_count;
+
+	int result = bounded_score;
+	if(!is_bounded_pruned)
+	{
+		pairs->station_count = door_count;
+		pairs->step_count    = step_count;
+		for(int station_idx = 0; station_idx < door_count; ++station_idx)
+		{
+			pairs->rects[station_idx] = rects[station_idx];
+			for(int target_idx = station_idx + 1; target_idx < door_count; ++target_idx)
+			{
+				pairs->distances [get_door_pair_idx(station_idx, target_idx)] = (uint16_t)distances[station_idx * door_count + target_idx];
+				pairs->footprints[get_door_pair_idx(station_idx, target_idx)] = footprints[station_idx * door_count + target_idx];
+			}
+		}
+
+		result = get_fitness_score_from_distances(app, factory, distances);
+	}
+
+	*is_pruned = is_bounded_pruned;
+
+	arena_end_scratch(scratch);
+
+	return result;
+}
+
+// pair_distances_update on the door distances the factory's lineage was last evaluated with, when that was in the last
+// generation. The new distances go to the next of the current generation's AppState::pair_distances, the way
+// get_fitness_score_hpa claims its graphs, and a pruned factory is left without any
+int get_fitness_score_delta(AppState *app, Factory *factory, PathFindOptions *options, FitnessDeltaStats *stats, int cutoff_score, bool *is_pruned)
+{
+	int pairs_idx = InterlockedIncrement(&app->pair_distances_count) - 1;
+	assert(pairs_idx < DESIRED_POPULATION_COUNT);
+
+	PairDistances *old_pairs = NULL;
+	if(factory->pair_distances_stamp > 0 && factory->pair_distances_stamp == app->generation_count)
+	{
+		old_pairs = &app->pair_distances[(app->generation_count + 1) % 2][factory->pair_distances_idx];
+	}
+
+	PairDistances *pairs = &app->pair_distances[app->generation_count % 2][pairs_idx];
+
+	int result = pair_distances_update(app, factory, old_pairs, pairs, options, stats, cutoff_score, is_pruned);
+
+	factory->pair_distances_stamp = *is_pruned ? 0 : app->generation_count + 1;
+	factory->pair_distances_idx   = pairs_idx;
+
+	return result;
+}
 
-			Station *target_station = factory->stations + target_offset + path_idx;
+// Same score as get_fitness_score with PATH_FIND_MODE_HPA on a graph of the factory's own. The graph starts as a copy
+// of the one its lineage was last evaluated on, when that was in the last generation, and only the dirty clusters are
+// rebuilt. Otherwise every cluster is.
+int get_fitness_score_hpa(AppState *app, Factory *factory, PathFindOptions *options)
+{
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	int       door_count = factory->station_count;
+	PathTile *doors      = arena_push_array(scratch.arena, door_count, PathTile);
+	int      *distances  = arena_push_array(scratch.arena, door_count * door_count, int);
+	get_factory_doors(factory, doors);
+
+	int graph_idx = InterlockedIncrement(&app->hpa_graph_count) - 1;
+	assert(graph_idx < DESIRED_POPULATION_COUNT);
+
+	HpaGraph *graph = &app->hpa_graphs[app->generation_count % 2][graph_idx];
+	if(factory->hpa_graph_stamp > 0 && factory->hpa_graph_stamp == app->generation_count)
+	{
+		*graph = app->hpa_graphs[(app->generation_count + 1) % 2][factory->hpa_graph_idx];
+		hpa_graph_update(graph, &factory->map, &factory->dirty_clusters, options->stats);
+	}else
+	{
+		hpa_graph_update(graph, &factory->map, NULL, options->stats);
+	}
+
+	factory->dirty_clusters  = {};
+	factory->hpa_graph_stamp = app->generation_count + 1;
+	factory->hpa_graph_idx   = graph_idx;
+
+	hpa_door_distances(graph, &factory->map, doors, door_count, get_fitness_step_count(app), distances, options->stats);
+
+	int result = get_fitness_score_from_distances(app, factory, distances);
+
+	arena_end_scratch(scratch);
+
+	return result;
+}
+
+// Door to door jobs for each factory, jobs[i] fills the upper triangle of row i of the factory's door matrix
+int get_fitness_jobs(Factory *factories, int factory_count, PathTile *doors, int *distances, PathFindJob *jobs)
+{
+	int job_count = 0;
+
+	for(int factory_idx = 0; factory_idx < factory_count; ++factory_idx)
+	{
+		Factory *factory    = &factories[factory_idx];
+		int      door_count = factory->station_count;
+
+		PathTile *factory_doors     = &doors    [factory_idx * DESIRED_STATION_COUNT];
+		int      *factory_distances = &distances[factory_idx * DESIRED_STATION_COUNT * DESIRED_STATION_COUNT];
+
+		get_factory_doors(factory, factory_doors);
+
+		for(int door_idx = 0; door_idx + 1 < door_count; ++door_idx)
+		{
+			int target_offset = door_idx + 1;
+
+			PathFindJob *job  = &jobs[job_count++];
+			job->map          = &factory->map;
+			job->start        = factory_doors[door_idx];
+			job->targets      = factory_doors + target_offset;
+			job->target_count = door_count - target_offset;
+			job->tile_counts  = factory_distances + door_idx * door_count + target_offset;
+		}
+	}
+
+	return job_count;
+}
+
+// Same scores as get_fitness_score for factories taken lane_count at a time by path_find_lockstep_door_distances
+void get_lockstep_fitness_scores(AppState *app, Factory *factories, int factory_count, int lane_count, int *scores, PathFindStats *stats)
+{
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	PathTile *doors     = arena_push_array(scratch.arena, MAX_LOCKSTEP_LANE_COUNT * DESIRED_STATION_COUNT, PathTile);
+	int      *distances = arena_push_array(scratch.arena, MAX_LOCKSTEP_LANE_COUNT * DESIRED_STATION_COUNT * DESIRED_STATION_COUNT, int);
+
+	for(int first_factory_idx = 0; first_factory_idx < factory_count; first_factory_idx += lane_count)
+	{
+		int sweep_lane_count = min(lane_count, factory_count - first_factory_idx);
+
+		OccupancyMap *lane_maps       [MAX_LOCKSTEP_LANE_COUNT];
+		PathTile     *lane_doors      [MAX_LOCKSTEP_LANE_COUNT];
+		int           lane_door_counts[MAX_LOCKSTEP_LANE_COUNT];
+		int          *lane_distances  [MAX_LOCKSTEP_LANE_COUNT];
+
+		for(int lane = 0; lane < sweep_lane_count; ++lane)
+		{
+			Factory *factory = &factories[first_factory_idx + lane];
+
+			lane_maps       [lane] = &factory->map;
+			lane_doors      [lane] = &doors[lane * DESIRED_STATION_COUNT];
+			lane_door_counts[lane] = factory->station_count;
+			lane_distances  [lane] = &distances[lane * DESIRED_STATION_COUNT * DESIRED_STATION_COUNT];
+
+			get_factory_doors(factory, lane_doors[lane]);
+		}
+
+		path_find_lockstep_door_distances(lane_maps, lane_doors, lane_door_counts, sweep_lane_count, get_fitness_step_count(app), lane_distances, stats);
+
+		for(int lane = 0; lane < sweep_lane_count; ++lane)
+		{
+			scores[first_factory_idx + lane] = get_fitness_score_from_distances(app, &factories[first_factory_idx + lane], lane_distances[lane]);
+		}
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// Same scores as get_fitness_score, with every factory's queries in one path_find_batch call. The modes with their
+// own door matrix routine (shared sweeps or shared per-door setup) are still scored factory by factory, and the modes
+// with exact depth-limited distances only search the pairs changed since the factory's last evaluation. With a
+// cutoff_score the modes that support it score their full evaluations by branch and bound and flag the pruned ones.
+void get_fitness_scores(AppState *app, Factory *factories, int factory_count, PathFindOptions *options, FitnessDeltaStats *delta_stats, int cutoff_score)
+{
+	if(path_find_mode_has_delta(options->mode))
+	{
+		FitnessDeltaStats ignored_stats = {};
+		if(!delta_stats)
+		{
+			delta_stats = &ignored_stats;
+		}
+
+		for(int factory_idx = 0; factory_idx < factory_count; ++factory_idx)
+		{
+			Factory *factory = &factories[factory_idx];
+
+			factory->fitness_score = get_fitness_score_delta(app, factory, options, delta_stats, cutoff_score, &factory->is_fitness_bound);
+		}
+	}else if(options->mode == PATH_FIND_MODE_HPA)
+	{
+		for(int factory_idx = 0; factory_idx < factory_count; ++factory_idx)
+		{
+			factories[factory_idx].fitness_score = get_fitness_score_hpa(app, &factories[factory_idx], options);
+		}
+	}else if(options->mode == PATH_FIND_MODE_VISIBILITY)
+	{
+		for(int factory_idx = 0; factory_idx < factory_count; ++factory_idx)
+		{
+			factories[factory_idx].fitness_score = get_fitness_score(app, &factories[factory_idx], options);
+		}
+	}else if(options->mode == PATH_FIND_MODE_LOCKSTEP)
+	{
+		TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+		int *scores = arena_push_array(scratch.arena, factory_count, int);
+		get_lockstep_fitness_scores(app, factories, factory_count, FITNESS_LOCKSTEP_LANE_COUNT, scores, options->stats);
+
+		for(int factory_idx = 0; factory_idx < factory_count; ++factory_idx)
+		{
+			factories[factory_idx].fitness_score = scores[factory_idx];
+		}
+
+		arena_end_scratch(scratch);
+	}else
+	{
+		TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+		PathTile    *doors     = arena_push_array(scratch.arena, factory_count * DESIRED_STATION_COUNT, PathTile);
+		int         *distances = arena_push_array(scratch.arena, factory_count * DESIRED_STATION_COUNT * DESIRED_STATION_COUNT, int);
+		PathFindJob *jobs      = arena_push_array(scratch.arena, factory_count * DESIRED_STATION_COUNT, PathFindJob);
+
+		int job_count = get_fitness_jobs(factories, factory_count, doors, distances, jobs);
+		path_find_batch(jobs, job_count, get_fitness_step_count(app), options);
+
+		// get_fitness_score_from_distances only reads the upper triangle the jobs filled
+		for(int factory_idx = 0; factory_idx < factory_count; ++factory_idx)
+		{
+			Factory *factory = &factories[factory_idx];
+			factory->fitness_score = get_fitness_score_from_distances(app, factory, &distances[factory_idx * DESIRED_STATION_COUNT * DESIRED_STATION_COUNT]);
+		}
+
+		arena_end_scratch(scratch);
+	}
+}
+
+// Sum of weight * (Manhattan distance + 1) over the door pairs, the terms get_fitness_score_from_distances sums with found
+// distances. Doors and the row's weights go into flat arrays first so that the pair loop vectorizes
+int64_t get_weighted_manhattan_sum(AppState *app, Factory *factory)
+{
+	int door_count = factory->station_count;
+
+	PathTile doors[DESIRED_STATION_COUNT];
+	get_factory_doors(factory, doors);
+
+	int xs     [DESIRED_STATION_COUNT];
+	int ys     [DESIRED_STATION_COUNT];
+	int weights[DESIRED_STATION_COUNT];
+	for(int station_idx = 0; station_idx < door_count; ++station_idx)
+	{
+		xs[station_idx] = doors[station_idx].x;
+		ys[station_idx] = doors[station_idx].y;
+	}
+
+	int64_t result = 0;
+	for(int station_idx = 0; station_idx < door_count; ++station_idx)
+	{
+		int *type_weights = app->station_weight_lut[factory->stations[station_idx].type];
+		for(int target_idx = station_idx + 1; target_idx < door_count; ++target_idx)
+		{
+			weights[target_idx] = type_weights[factory->stations[target_idx].type];
+		}
+
+		int x = xs[station_idx];
+		int y = ys[station_idx];
+
+		int row_sum = 0;
+		for(int target_idx = station_idx + 1; target_idx < door_count; ++target_idx)
+		{
+			row_sum += weights[target_idx] * (abs(xs[target_idx] - x) + abs(ys[target_idx] - y) + 1);
+		}
+
+		result += row_sum;
+	}
+
+	return result;
+}
+
+// Estimated fitness score, the weighted Manhattan sum stretched by the detour learned from searched factories
+int get_surrogate_score(AppState *app, int64_t weighted_manhattan_sum)
+{
+	int result = 1000000 - (int)(app->surrogate_detour * weighted_manhattan_sum);
+	return result;
+}
+
+// Factories out of factory_count that screening sends to search, at least one
+int get_surrogate_search_count(AppState *app, int factory_count)
+{
+	int result = max((int)(app->surrogate_search_fraction * factory_count + 0.5f), 1);
+	return result;
+}
+
+// Sorts the indices in unsorted by their value, lowest first. Both arrays end up sorted
+void merge_sort_value_idxs(int *sorted, int *unsorted, int count, int64_t *values)
+{
+	if(count <= 1)
+	{
+		return;
+	}
+
+	int l = count / 2;
+	int r = count - l;
+
+	merge_sort_value_idxs(    sorted,     unsorted, l, values);
+	merge_sort_value_idxs(&sorted[l], &unsorted[l], r, values);
+
+	int *src_l = unsorted;
+	int *src_r = &unsorted[l];
+
+	int *end_l = src_r;
+	int *end_r = &unsorted[count];
+
+	for(int i = 0; i < count; ++i)
+	{
+		int *record = &sorted[i];
+
+		if(src_l == end_l)
+		{
+			*record = *src_r++;
+		}else if(src_r == end_r)
+		{
+			*record = *src_l++;
+		}else if(values[*src_r] < values[*src_l])
+		{
+			*record = *src_r++;
+		}else
+		{
+			*record = *src_l++;
+		}
+	}
+
+	memcpy(unsorted, sorted, count * sizeof(int));
+}
+
+// 0 for the lowest value, ties share the mean of their ranks
+void get_ranks(int64_t *values, int count, float *ranks)
+{
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	int *value_idxs  = arena_push_array(scratch.arena, count, int);
+	int *sorted_idxs = arena_push_array(scratch.arena, count, int);
+	for(int value_idx = 0; value_idx < count; ++value_idx)
+	{
+		value_idxs[value_idx] = value_idx;
+	}
+	merge_sort_value_idxs(sorted_idxs, value_idxs, count, values);
+
+	// Each run of equal values covers the ranks [first_idx, end_idx)
+	int first_idx = 0;
+	while(first_idx < count)
+	{
+		int end_idx = first_idx + 1;
+		while(end_idx < count && values[sorted_idxs[end_idx]] == values[sorted_idxs[first_idx]])
+		{
+			end_idx++;
+		}
+
+		for(int i = first_idx; i < end_idx; ++i)
+		{
+			ranks[sorted_idxs[i]] = (first_idx + end_idx - 1) * 0.5f;
+		}
+
+		first_idx = end_idx;
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// Spearman's rank correlation, 1 when both orders agree and -1 when they are reversed
+float get_rank_correlation(int64_t *a, int64_t *b, int count)
+{
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	float *ranks_a = arena_push_array(scratch.arena, count, float);
+	float *ranks_b = arena_push_array(scratch.arena, count, float);
+	get_ranks(a, count, ranks_a);
+	get_ranks(b, count, ranks_b);
+
+	float mean_rank  = (count - 1) * 0.5f;
+	float covariance = 0;
+	float variance_a = 0;
+	float variance_b = 0;
+	for(int value_idx = 0; value_idx < count; ++value_idx)
+	{
+		float offset_a = ranks_a[value_idx] - mean_rank;
+		float offset_b = ranks_b[value_idx] - mean_rank;
+
+		covariance += offset_a * offset_b;
+		variance_a += offset_a * offset_a;
+		variance_b += offset_b * offset_b;
+	}
+
+	float result = 0;
+	if(variance_a > 0 && variance_b > 0)
+	{
+		result = covariance / sqrtf(variance_a * variance_b);
+	}
+
+	arena_end_scratch(scratch);
+
+	return result;
+}
+
+// Mutation step, shifts a station if the new spot is free. The map is left unchanged when it is not.
+bool move_station(Factory *factory, Station *station, int shift_x, int shift_y)
+{
+	Station new_station = *station;
+
+	new_station.x0 = station->x0 + shift_x;
+	new_station.y0 = station->y0 + shift_y;
+
+	new_station.x1 = station->x1 + shift_x;
+	new_station.y1 = station->y1 + shift_y;
+
+	bool result = false;
+
+	write_to_map(factory, station, 0);
+	if(!test_overlap(factory, &new_station))
+	{
+		write_to_map(factory, &new_station, 1);
+		*station = new_station;
+
+		result = true;
+	}else
+	{
+		write_to_map(factory, station, 1);
+	}
+
+	return result;
+}
+
+// Evaluates the whole population single threaded with the given options and records the timing
+void bench_path_find(AppState *app, PathFindOptions *options)
+{
+	if(app->bench_result_count < MAX_BENCH_RESULT_COUNT)
+	{
+		BenchResult *result = &app->bench_results[app->bench_result_count++];
+
+		stbsp_snprintf(result->name, sizeof(result->name), "%s", path_find_mode_name(options->mode));
+		if(options->mode == PATH_FIND_MODE_A_STAR || options->mode == PATH_FIND_MODE_JPS)
+		{
+			stbsp_snprintf(result->name, sizeof(result->name), "%s (%s)", path_find_mode_name(options->mode), path_find_queue_name(options->queue));
+		}
+
+		PathFindOptions bench_options = *options;
+		bench_options.stats           = &result->stats;
+
+		uint64_t start = time_get_microsecs();
+
+		for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+		{
+			result->score_sum += get_fitness_score(app, &app->population[factory_idx], &bench_options);
+		}
+
+		result->microsecs = time_get_microsecs() - start;
+	}
+}
+
+// Moves one station per factory the way mutation does, timing the HPA* graph update for the touched clusters
+// against a rebuild of every cluster. Both rows report the HPA* score sum of the moved factories.
+void bench_hpa_update(AppState *app)
+{
+	if(app->bench_result_count + 2 > MAX_BENCH_RESULT_COUNT)
+	{
+		return;
+	}
+
+	BenchResult *update_result  = &app->bench_results[app->bench_result_count++];
+	BenchResult *rebuild_result = &app->bench_results[app->bench_result_count++];
+
+	stbsp_snprintf(update_result->name,  sizeof(update_result->name),  "HPA* Cluster Update");
+	stbsp_snprintf(rebuild_result->name, sizeof(rebuild_result->name), "HPA* Full Rebuild");
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	HpaGraph *graph     = arena_push_array(scratch.arena, 1, HpaGraph);
+	PathTile *doors     = arena_push_array(scratch.arena, DESIRED_STATION_COUNT, PathTile);
+	int      *distances = arena_push_array(scratch.arena, DESIRED_STATION_COUNT * DESIRED_STATION_COUNT, int);
+	Factory  *factory   = arena_push_array(scratch.arena, 1, Factory);
+
+	// Fixed seed so repeated runs move the same stations
+	unsigned int rng_seed   = 1;
+	int          step_count = get_fitness_step_count(app);
+
+	for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+	{
+		*factory = app->population[factory_idx];
+
+		hpa_graph_update(graph, &factory->map, NULL);
+		factory->dirty_clusters = {};
+
+		int      station_idx = random(&rng_seed) % factory->station_count;
+		Station *station     = &factory->stations[station_idx];
+
+		int shift_x_count = (random(&rng_seed) % 4) - 2;
+		int shift_y_count = (random(&rng_seed) % 4) - 2;
+
+		if(move_station(factory, station, shift_x_count, shift_y_count))
+		{
+			get_factory_doors(factory, doors);
+
+			uint64_t update_start = time_get_microsecs();
+
+			hpa_graph_update  (graph, &factory->map, &factory->dirty_clusters, &update_result->stats);
+			hpa_door_distances(graph, &factory->map, doors, factory->station_count, step_count, distances, &update_result->stats);
+
+			update_result->microsecs += time_get_microsecs() - update_start;
+			update_result->score_sum += get_fitness_score_from_distances(app, factory, distances);
+
+			uint64_t rebuild_start = time_get_microsecs();
+
+			hpa_graph_update  (graph, &factory->map, NULL, &rebuild_result->stats);
+			hpa_door_distances(graph, &factory->map, doors, factory->station_count, step_count, distances, &rebuild_result->stats);
+
+			rebuild_result->microsecs += time_get_microsecs() - rebuild_start;
+			rebuild_result->score_sum += get_fitness_score_from_distances(app, factory, distances);
+		}
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// Same moves as bench_hpa_update, timing the visibility graph update for the moved station against a
+// rebuild of the whole graph. Both rows report the score sum of the moved factories.
+void bench_visibility_update(AppState *app)
+{
+	if(app->bench_result_count + 2 > MAX_BENCH_RESULT_COUNT)
+	{
+		return;
+	}
+
+	BenchResult *update_result  = &app->bench_results[app->bench_result_count++];
+	BenchResult *rebuild_result = &app->bench_results[app->bench_result_count++];
+
+	stbsp_snprintf(update_result->name,  sizeof(update_result->name),  "Visibility Update");
+	stbsp_snprintf(rebuild_result->name, sizeof(rebuild_result->name), "Visibility Rebuild");
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	VisibilityGraph *graph         = arena_push_array(scratch.arena, 1, VisibilityGraph);
+	VisibilityGraph *rebuilt_graph = arena_push_array(scratch.arena, 1, VisibilityGraph);
+	PathTile        *doors         = arena_push_array(scratch.arena, DESIRED_STATION_COUNT, PathTile);
+	MapRect         *rects         = arena_push_array(scratch.arena, DESIRED_STATION_COUNT, MapRect);
+	int             *distances     = arena_push_array(scratch.arena, DESIRED_STATION_COUNT * DESIRED_STATION_COUNT, int);
+	Factory         *factory       = arena_push_array(scratch.arena, 1, Factory);
+
+	unsigned int rng_seed   = 1;
+	int          step_count = get_fitness_step_count(app);
+
+	for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+	{
+		*factory = app->population[factory_idx];
+
+		get_factory_doors(factory, doors);
+		get_factory_rects(factory, rects);
+
+		graph->rect_count = 0;
+		visibility_graph_update(graph, &factory->map, rects, doors, factory->station_count);
+
+		int      station_idx = random(&rng_seed) % factory->station_count;
+		Station *station     = &factory->stations[station_idx];
+
+		int shift_x_count = (random(&rng_seed) % 4) - 2;
+		int shift_y_count = (random(&rng_seed) % 4) - 2;
+
+		if(move_station(factory, station, shift_x_count, shift_y_count))
+		{
+			get_factory_doors(factory, doors);
+			get_factory_rects(factory, rects);
+
+			uint64_t update_start = time_get_microsecs();
+
+			visibility_graph_update  (graph, &factory->map, rects, doors, factory->station_count, &update_result->stats);
+			visibility_door_distances(graph, step_count, distances, &update_result->stats);
+
+			update_result->microsecs += time_get_microsecs() - update_start;
+			update_result->score_sum += get_fitness_score_from_distances(app, factory, distances);
+
+			uint64_t rebuild_start = time_get_microsecs();
+
+			rebuilt_graph->rect_count = 0;
+			visibility_graph_update  (rebuilt_graph, &factory->map, rects, doors, factory->station_count, &rebuild_result->stats);
+			visibility_door_distances(rebuilt_graph, step_count, distances, &rebuild_result->stats);
+
+			rebuild_result->microsecs += time_get_microsecs() - rebuild_start;
+			rebuild_result->score_sum += get_fitness_score_from_distances(app, factory, distances);
+		}
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// Same moves as bench_hpa_update, timing pair_distances_update from the distances before the move against a full
+// evaluation. query_count is the pairs each row searched, both rows report the score sum of the moved factories.
+void bench_delta_update(AppState *app)
+{
+	if(app->bench_result_count + 2 > MAX_BENCH_RESULT_COUNT)
+	{
+		return;
+	}
+
+	BenchResult *update_result = &app->bench_results[app->bench_result_count++];
+	BenchResult *full_result   = &app->bench_results[app->bench_result_count++];
+
+	stbsp_snprintf(update_result->name, sizeof(update_result->name), "Bits Delta Update");
+	stbsp_snprintf(full_result->name,   sizeof(full_result->name),   "Bits Full Evaluation");
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	PairDistances *old_pairs = arena_push_array(scratch.arena, 1, PairDistances);
+	PairDistances *pairs     = arena_push_array(scratch.arena, 1, PairDistances);
+	Factory       *factory   = arena_push_array(scratch.arena, 1, Factory);
+
+	PathFindOptions options = {};
+	options.mode            = PATH_FIND_MODE_BITS;
+
+	unsigned int rng_seed = 1;
+
+	for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+	{
+		*factory = app->population[factory_idx];
+
+		FitnessDeltaStats delta_stats = {};
+		bool              is_pruned   = false;
+		pair_distances_update(app, factory, NULL, old_pairs, &options, &delta_stats, INT_MIN, &is_pruned);
+
+		int      station_idx = random(&rng_seed) % factory->station_count;
+		Station *station     = &factory->stations[station_idx];
+
+		int shift_x_count = (random(&rng_seed) % 4) - 2;
+		int shift_y_count = (random(&rng_seed) % 4) - 2;
+
+		if(move_station(factory, station, shift_x_count, shift_y_count))
+		{
+			delta_stats = {};
+
+			uint64_t update_start = time_get_microsecs();
+
+			options.stats = &update_result->stats;
+			update_result->score_sum += pair_distances_update(app, factory, old_pairs, pairs, &options, &delta_stats, INT_MIN, &is_pruned);
+
+			update_result->microsecs   += time_get_microsecs() - update_start;
+			update_result->query_count += delta_stats.searched_pair_count;
+
+			uint64_t full_start = time_get_microsecs();
+
+			options.stats = &full_result->stats;
+			full_result->score_sum += get_fitness_score(app, factory, &options);
+
+			full_result->microsecs   += time_get_microsecs() - full_start;
+			full_result->query_count += delta_stats.pair_count;
+
+			options.stats = NULL;
+		}
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// One-off door to door queries between stations half the station list apart, the long routes the draw path is
+// made of. score_sum is the sum of path lengths.
+void bench_single_queries(AppState *app, PathFindOptions *options)
+{
+	if(app->bench_result_count < MAX_BENCH_RESULT_COUNT)
+	{
+		BenchResult *result = &app->bench_results[app->bench_result_count++];
+
+		stbsp_snprintf(result->name, sizeof(result->name), "Single %s (%s%s)", path_find_mode_name(options->mode), path_find_queue_name(options->queue), options->bidirectional ? ", bidirectional" : "");
+
+		PathFindOptions bench_options = *options;
+		bench_options.stats           = &result->stats;
+
+		TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+		PathTile *doors      = arena_push_array(scratch.arena, DESIRED_STATION_COUNT, PathTile);
+		int       step_count = get_fitness_step_count(app);
+
+		uint64_t start = time_get_microsecs();
+
+		for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+		{
+			Factory *factory = &app->population[factory_idx];
+			get_factory_doors(factory, doors);
+
+			int half_count = factory->station_count / 2;
+			for(int door_idx = 0; door_idx < half_count; ++door_idx)
+			{
+				PathTile *start_door  = &doors[door_idx];
+				PathTile *target_door = &doors[door_idx + half_count];
+
+				TmpArena path_scratch = tmp_arena_begin(scratch.arena);
+
+				FoundPath path = path_find_target(&factory->map, start_door->x, start_door->y, target_door->x, target_door->y, step_count, path_scratch.arena, &bench_options);
+				result->score_sum += path.tile_count;
+
+				tmp_arena_end(path_scratch);
+			}
+		}
+
+		result->microsecs = time_get_microsecs() - start;
+
+		arena_end_scratch(scratch);
+	}
+}
+
+// Door matrices under a search policy checked against exact ones from PATH_FIND_MODE_BITS. Searches are uncapped
+// so every length is a whole path. score_sum is the sum of path lengths, only the policy's searches are timed.
+void bench_search_policy(AppState *app, PathFindOptions *options)
+{
+	if(app->bench_result_count < MAX_BENCH_RESULT_COUNT)
+	{
+		BenchResult *result = &app->bench_results[app->bench_result_count++];
+
+		if(options->policy == PATH_FIND_POLICY_WEIGHTED)
+		{
+			stbsp_snprintf(result->name, sizeof(result->name), "Policy %s x%.2f (%s)", path_find_policy_name(options->policy), options->weight, path_find_mode_name(options->mode));
+		}else
+		{
+			stbsp_snprintf(result->name, sizeof(result->name), "Policy %s (%s)", path_find_policy_name(options->policy), path_find_mode_name(options->mode));
+		}
+
+		result->has_length_excess = true;
+
+		PathFindOptions bench_options = *options;
+		bench_options.stats           = &result->stats;
+
+		PathFindOptions exact_options = {};
+		exact_options.mode            = PATH_FIND_MODE_BITS;
+
+		TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+		PathTile *doors           = arena_push_array(scratch.arena, DESIRED_STATION_COUNT, PathTile);
+		int      *distances       = arena_push_array(scratch.arena, DESIRED_STATION_COUNT * DESIRED_STATION_COUNT, int);
+		int      *exact_distances = arena_push_array(scratch.arena, DESIRED_STATION_COUNT * DESIRED_STATION_COUNT, int);
+
+		for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+		{
+			Factory *factory    = &app->population[factory_idx];
+			int      door_count = factory->station_count;
+
+			get_factory_doors(factory, doors);
+
+			uint64_t start = time_get_microsecs();
+			path_find_door_distances(&factory->map, doors, door_count, MAP_W * MAP_H, distances, &bench_options);
+			result->microsecs += time_get_microsecs() - start;
+
+			path_find_door_distances(&factory->map, doors, door_count, MAP_W * MAP_H, exact_distances, &exact_options);
+
+			for(int station_idx = 0; station_idx < door_count; ++station_idx)
+			{
+				for(int target_idx = station_idx + 1; target_idx < door_count; ++target_idx)
+				{
+					int length = distances      [station_idx * door_count + target_idx];
+					int excess = length - exact_distances[station_idx * door_count + target_idx];
+
+					result->score_sum         += length;
+					result->length_excess_sum += excess;
+					result->length_excess_max  = max(result->length_excess_max, excess);
+				}
+			}
+		}
+
+		arena_end_scratch(scratch);
+	}
+}
+
+// Counts the door pairs where A* over the given storage differs from A* on the heap at the fitness step cap. Searches
+// that finish agree, the queues break ties differently so capped searches can give up on different nodes
+void bench_queue_agreement(AppState *app, PathFindOptions *options)
+{
+	if(app->bench_result_count < MAX_BENCH_RESULT_COUNT)
+	{
+		BenchResult *result = &app->bench_results[app->bench_result_count++];
+		stbsp_snprintf(result->name, sizeof(result->name), "Agreement %s", path_find_mode_name(options->mode));
+		if(options->mode == PATH_FIND_MODE_A_STAR || options->mode == PATH_FIND_MODE_JPS)
+		{
+			stbsp_snprintf(result->name, sizeof(result->name), "Agreement %s (%s)", path_find_mode_name(options->mode), path_find_queue_name(options->queue));
+		}
+
+		result->has_mismatch_count = true;
+
+		PathFindOptions bench_options = *options;
+		bench_options.stats           = &result->stats;
+
+		PathFindOptions heap_options = {};
+		heap_options.mode            = PATH_FIND_MODE_A_STAR;
+		heap_options.queue           = PATH_FIND_QUEUE_HEAP;
+
+		TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+		PathTile *doors          = arena_push_array(scratch.arena, DESIRED_STATION_COUNT, PathTile);
+		int      *distances      = arena_push_array(scratch.arena, DESIRED_STATION_COUNT * DESIRED_STATION_COUNT, int);
+		int      *heap_distances = arena_push_array(scratch.arena, DESIRED_STATION_COUNT * DESIRED_STATION_COUNT, int);
+
+		int step_count = get_fitness_step_count(app);
+		for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+		{
+			Factory *factory    = &app->population[factory_idx];
+			int      door_count = factory->station_count;
+
+			get_factory_doors(factory, doors);
+
+			uint64_t start = time_get_microsecs();
+			path_find_door_distances(&factory->map, doors, door_count, step_count, distances, &bench_options);
+			result->microsecs += time_get_microsecs() - start;
+
+			path_find_door_distances(&factory->map, doors, door_count, step_count, heap_distances, &heap_options);
+
+			for(int pair_idx = 0; pair_idx < door_count * door_count; ++pair_idx)
+			{
+				result->score_sum      += distances[pair_idx];
+				result->mismatch_count += distances[pair_idx] != heap_distances[pair_idx];
+			}
+		}
+
+		arena_end_scratch(scratch);
+	}
+}
+
+// Population fitness with lane_count factories per lockstep sweep, to see how throughput scales with the lane count
+void bench_lockstep(AppState *app, int lane_count)
+{
+	if(app->bench_result_count < MAX_BENCH_RESULT_COUNT)
+	{
+		BenchResult *result = &app->bench_results[app->bench_result_count++];
+
+		stbsp_snprintf(result->name, sizeof(result->name), "%s x%d", path_find_mode_name(PATH_FIND_MODE_LOCKSTEP), lane_count);
+
+		TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+		int *scores = arena_push_array(scratch.arena, app->population_count, int);
+
+		uint64_t start = time_get_microsecs();
+
+		get_lockstep_fitness_scores(app, app->population, app->population_count, lane_count, scores, &result->stats);
+
+		result->microsecs = time_get_microsecs() - start;
+
+		for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+		{
+			result->score_sum += scores[factory_idx];
+		}
+
+		arena_end_scratch(scratch);
+	}
+}
+
+// Every factory's fitness queries through path_find_batch and through one path_find_target_distances call per
+// job. score_sum is the sum of tile counts so the two can be checked for agreement.
+void bench_batch(AppState *app, PathFindOptions *options)
+{
+	if(app->bench_result_count + 2 > MAX_BENCH_RESULT_COUNT)
+	{
+		return;
+	}
+
+	BenchResult *batch_result    = &app->bench_results[app->bench_result_count++];
+	BenchResult *per_call_result = &app->bench_results[app->bench_result_count++];
+
+	stbsp_snprintf(batch_result->name,    sizeof(batch_result->name),    "Batch %s (%s)",    path_find_mode_name(options->mode), path_find_queue_name(options->queue));
+	stbsp_snprintf(per_call_result->name, sizeof(per_call_result->name), "Per-Call %s (%s)", path_find_mode_name(options->mode), path_find_queue_name(options->queue));
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	int          factory_count = app->population_count;
+	PathTile    *doors         = arena_push_array(scratch.arena, factory_count * DESIRED_STATION_COUNT, PathTile);
+	int         *distances     = arena_push_array(scratch.arena, factory_count * DESIRED_STATION_COUNT * DESIRED_STATION_COUNT, int);
+	PathFindJob *jobs          = arena_push_array(scratch.arena, factory_count * DESIRED_STATION_COUNT, PathFindJob);
+
+	int job_count  = get_fitness_jobs(app->population, factory_count, doors, distances, jobs);
+	int step_count = get_fitness_step_count(app);
+
+	BenchResult *results[] = {batch_result, per_call_result};
+	for(int result_idx = 0; result_idx < array_count(results); ++result_idx)
+	{
+		BenchResult *result = results[result_idx];
+
+		PathFindOptions bench_options = *options;
+		bench_options.stats           = &result->stats;
+
+		uint64_t start = time_get_microsecs();
+
+		if(result == batch_result)
+		{
+			path_find_batch(jobs, job_count, step_count, &bench_options);
+		}else
+		{
+			for(int job_idx = 0; job_idx < job_count; ++job_idx)
+			{
+				PathFindJob *job = &jobs[job_idx];
+				path_find_target_distances(job->map, job->start.x, job->start.y, job->targets, job->target_count, step_count, job->tile_counts, &bench_options);
+			}
+		}
+
+		result->microsecs = time_get_microsecs() - start;
+
+		for(int job_idx = 0; job_idx < job_count; ++job_idx)
+		{
+			PathFindJob *job = &jobs[job_idx];
+			for(int target_idx = 0; target_idx < job->target_count; ++target_idx)
+			{
+				result->score_sum += job->tile_counts[target_idx];
+			}
+
+			result->query_count += job->target_count;
+		}
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// Landmark precomputation on its own next to the full door matrices with it, the difference is the search cost to
+// hold against the PATH_FIND_MODE_A_STAR row
+void bench_landmarks(AppState *app, int landmark_count)
+{
+	if(app->bench_result_count + 2 > MAX_BENCH_RESULT_COUNT)
+	{
+		return;
+	}
+
+	BenchResult *build_result = &app->bench_results[app->bench_result_count++];
+	BenchResult *alt_result   = &app->bench_results[app->bench_result_count++];
+
+	stbsp_snprintf(build_result->name, sizeof(build_result->name), "%s Landmarks x%d", path_find_mode_name(PATH_FIND_MODE_ALT), landmark_count);
+	stbsp_snprintf(alt_result->name,   sizeof(alt_result->name),   "%s x%d",           path_find_mode_name(PATH_FIND_MODE_ALT), landmark_count);
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	LandmarkFields *fields = arena_push_array(scratch.arena, 1, LandmarkFields);
+
+	uint64_t start = time_get_microsecs();
+
+	for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+	{
+		landmark_fields_build(fields, &app->population[factory_idx].map, landmark_count, &build_result->stats);
+	}
+
+	build_result->microsecs = time_get_microsecs() - start;
+
+	PathFindOptions options = {};
+	options.mode            = PATH_FIND_MODE_ALT;
+	options.landmark_count  = landmark_count;
+	options.stats           = &alt_result->stats;
+
+	start = time_get_microsecs();
+
+	for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+	{
+		alt_result->score_sum += get_fitness_score(app, &app->population[factory_idx], &options);
+	}
+
+	alt_result->microsecs = time_get_microsecs() - start;
+
+	arena_end_scratch(scratch);
+}
+
+// Surrogate scores of the population against searched A* scores. The overlap counts how many of the factories screening
+// would send to search are also in the searched top, the rest are good factories screening would lose
+void bench_surrogate(AppState *app)
+{
+	if(app->bench_result_count >= MAX_BENCH_RESULT_COUNT)
+	{
+		return;
+	}
+
+	BenchResult *result = &app->bench_results[app->bench_result_count++];
+	stbsp_snprintf(result->name, sizeof(result->name), "Surrogate (top %d%%)", (int)(100 * app->surrogate_search_fraction + 0.5f));
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	int      factory_count    = app->population_count;
+	int64_t *surrogate_scores = arena_push_array(scratch.arena, factory_count, int64_t);
+	int64_t *searched_scores  = arena_push_array(scratch.arena, factory_count, int64_t);
+
+	uint64_t start = time_get_microsecs();
+
+	for(int factory_idx = 0; factory_idx < factory_count; ++factory_idx)
+	{
+		surrogate_scores[factory_idx] = get_surrogate_score(app, get_weighted_manhattan_sum(app, &app->population[factory_idx]));
+	}
+
+	result->microsecs = time_get_microsecs() - start;
+
+	PathFindOptions options = {};
+	for(int factory_idx = 0; factory_idx < factory_count; ++factory_idx)
+	{
+		searched_scores[factory_idx] = get_fitness_score(app, &app->population[factory_idx], &options);
+		result->score_sum           += surrogate_scores[factory_idx];
+	}
+
+	float *surrogate_ranks = arena_push_array(scratch.arena, factory_count, float);
+	float *searched_ranks  = arena_push_array(scratch.arena, factory_count, float);
+	get_ranks(surrogate_scores, factory_count, surrogate_ranks);
+	get_ranks(searched_scores,  factory_count, searched_ranks);
+
+	// Ranks count up from the lowest score
+	int top_rank = factory_count - get_surrogate_search_count(app, factory_count);
+	for(int factory_idx = 0; factory_idx < factory_count; ++factory_idx)
+	{
+		bool is_surrogate_top = surrogate_ranks[factory_idx] >= top_rank;
+		bool is_searched_top  = searched_ranks [factory_idx] >= top_rank;
+
+		result->top_count         += is_surrogate_top;
+		result->top_overlap_count += is_surrogate_top && is_searched_top;
+	}
+
+	result->has_rank_correlation = true;
+	result->rank_correlation     = get_rank_correlation(surrogate_scores, searched_scores, factory_count);
+
+	arena_end_scratch(scratch);
+}
+
+void bench_run(AppState *app)
+{
+	app->bench_result_count = 0;
+	mem_zero_array(app->bench_results, MAX_BENCH_RESULT_COUNT);
+
+	PathFindOptions options = {};
+
+	options.mode  = PATH_FIND_MODE_A_STAR;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_path_find(app, &options);
+
+	options.mode  = PATH_FIND_MODE_A_STAR;
+	options.queue = PATH_FIND_QUEUE_BUCKET;
+	bench_path_find(app, &options);
+
+	options.mode  = PATH_FIND_MODE_FLOOD;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_path_find(app, &options);
+
+	options.mode  = PATH_FIND_MODE_JPS;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_path_find(app, &options);
+
+	options.mode  = PATH_FIND_MODE_JPS;
+	options.queue = PATH_FIND_QUEUE_BUCKET;
+	bench_path_find(app, &options);
+
+	options.mode  = PATH_FIND_MODE_BITS;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_path_find(app, &options);
+
+	options.mode  = PATH_FIND_MODE_MULTI;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_path_find(app, &options);
+
+	options.mode  = PATH_FIND_MODE_SOA;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_path_find(app, &options);
+
+	options.mode  = PATH_FIND_MODE_HPA;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_path_find(app, &options);
+
+	options.mode  = PATH_FIND_MODE_VISIBILITY;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_path_find(app, &options);
+
+	for(int lane_count = 1; lane_count <= MAX_LOCKSTEP_LANE_COUNT; lane_count *= 2)
+	{
+		bench_lockstep(app, lane_count);
+	}
+
+	for(int landmark_count = 1; landmark_count <= MAX_LANDMARK_COUNT; landmark_count *= 2)
+	{
+		bench_landmarks(app, landmark_count);
+	}
+
+	bench_surrogate(app);
+	bench_hpa_update(app);
+	bench_visibility_update(app);
+	bench_delta_update(app);
+
+	options.mode  = PATH_FIND_MODE_A_STAR;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_single_queries(app, &options);
+
+	options.bidirectional = true;
+	bench_single_queries(app, &options);
+
+	options.bidirectional = false;
+	options.policy        = PATH_FIND_POLICY_OPTIMAL;
+	bench_search_policy(app, &options);
+
+	float weights[] = {1.25f, 1.5f, 2.0f};
+	for(int weight_idx = 0; weight_idx < array_count(weights); ++weight_idx)
+	{
+		options.policy = PATH_FIND_POLICY_WEIGHTED;
+		options.weight = weights[weight_idx];
+		bench_search_policy(app, &options);
+	}
+
+	options.policy = PATH_FIND_POLICY_GREEDY;
+	bench_search_policy(app, &options);
+
+	options.policy = PATH_FIND_POLICY_OPTIMAL;
+	options.mode   = PATH_FIND_MODE_A_STAR;
+	options.queue  = PATH_FIND_QUEUE_BUCKET;
+	bench_queue_agreement(app, &options);
+
+	options.mode  = PATH_FIND_MODE_SOA;
+	options.queue = PATH_FIND_QUEUE_HEAP;
+	bench_queue_agreement(app, &options);
+
+	// Per-call HPA* would rebuild the graph for every job, that comparison is left out
+	options.policy = PATH_FIND_POLICY_OPTIMAL;
+	options.mode   = PATH_FIND_MODE_A_STAR;
+	bench_batch(app, &options);
+
+	options.mode = PATH_FIND_MODE_BITS;
+	bench_batch(app, &options);
+}
+
+struct ThreadedGeneration
+{
+	AppState     *app;
+	unsigned int  rng_seed;
+
+	int      population_count;
+	int      generated_count;
+	Factory *population;
+};
 
-			int weight = app->station_weight_lut[station->type][target_station->type];
+// Factories that come up short of DESIRED_STATION_COUNT are drawn again until the slice is full
+work_queue_callback(threaded_generation)
+{
+	ThreadedGeneration *generation = (ThreadedGeneration *)user_params;
 
-			result -= path->tile_count * weight;
-#if 0
-			for(int tile_idx = 0; tile_idx < path->tile_count; ++tile_idx)
-			{
-				PathTile *tile = &path->tiles[tile_idx];
-				draw_rect(tile->x, tile->y, 1, 1, 1, 1, 1);
-			}
-#endif
+	while(generation->generated_count < generation->population_count)
+	{
+		Factory factory = generate_factory(generation->app, &generation->rng_seed);
+		if(factory.station_count == DESIRED_STATION_COUNT)
+		{
+			generation->population[generation->generated_count++] = factory;
 		}
 	}
-
-	arena_end_scratch(scratch);
-
-	return result;
 }
 
-AppState app_make(const char *font_filename, unsigned int rng_seed, Arena *permanent_arena)
+AppState app_make(const char *font_filename, unsigned int rng_seed, WorkQueue *work_queue, Arena *permanent_arena)
 {
 	AppState result = {};
 	result.font     = load_font(font_filename);
@@ -341,6 +1853,12 @@ AppState app_make(const char *font_filename, unsigned int rng_seed, Arena *perma
 
 	result.rng_seed = rng_seed;
 
+	result.path_find_options.weight = 1.5f;
+	result.fitness_cutoff_score     = INT_MIN;
+
+	result.surrogate_search_fraction = 0.5f;
+	result.surrogate_detour          = 1.0f;
+
 	result.station_types[0] = {0, 0, 1, 8, 8,  4, -1};
 	result.station_types[1] = {0, 1, 0, 4, 4,  4,  2};
 	result.station_types[2] = {0, 1, 1, 2, 2,  1,  2};
@@ -357,49 +1875,240 @@ AppState app_make(const char *font_filename, unsigned int rng_seed, Arena *perma
 
 	result.population = arena_push_array(permanent_arena, DESIRED_POPULATION_COUNT, Factory);
 
-	for(int i = 0; i < DESIRED_POPULATION_COUNT; ++i)
+	result.hpa_graphs[0] = arena_push_array(permanent_arena, DESIRED_POPULATION_COUNT, HpaGraph);
+	result.hpa_graphs[1] = arena_push_array(permanent_arena, DESIRED_POPULATION_COUNT, HpaGraph);
+
+	result.pair_distances[0] = arena_push_array(permanent_arena, DESIRED_POPULATION_COUNT, PairDistances);
+	result.pair_distances[1] = arena_push_array(permanent_arena, DESIRED_POPULATION_COUNT, PairDistances);
+
+	result.fitness_cache.slots      = arena_push_array(permanent_arena, FITNESS_CACHE_SLOT_COUNT, int64_t);
+	result.fitness_cache.options    = result.path_find_options;
+	result.fitness_cache.step_count = get_fitness_step_count(&result);
+
+	// Every task draws from its own seed so the population does not depend on which thread runs which slice
+	ThreadedGeneration generations[THREAD_COUNT] = {};
+
+	int population_count_per_thread = DESIRED_POPULATION_COUNT / THREAD_COUNT;
+	int population_count_remainder  = DESIRED_POPULATION_COUNT % THREAD_COUNT;
+
+	for(int thread_idx = 0; thread_idx < THREAD_COUNT; ++thread_idx)
 	{
-		Factory factory = generate_factory(&result, permanent_arena);
-		if(factory.station_count == DESIRED_STATION_COUNT)
+		ThreadedGeneration *generation = &generations[thread_idx];
+		generation->app                = &result;
+		generation->rng_seed           = random(&result.rng_seed);
+		generation->population_count   = population_count_per_thread;
+		generation->population         = result.population + population_count_per_thread * thread_idx;
+
+		if(thread_idx == THREAD_COUNT - 1)
 		{
-			result.population[result.population_count++] = factory;
+			generation->population_count += population_count_remainder;
 		}
+
+		work_queue_push_work(work_queue, threaded_generation, generation);
 	}
 
+	work_queue_work_until_done(work_queue, 0);
+
+	// Every slice is full, so the slices already make up the whole population
+	result.population_count = DESIRED_POPULATION_COUNT;
+
 	return result;
 }
 
-struct ThreadedSelection
+bool path_find_options_match(PathFindOptions *a, PathFindOptions *b)
+{
+	bool result = a->mode == b->mode && a->queue == b->queue && a->policy == b->policy && a->weight == b->weight &&
+	              a->bidirectional == b->bidirectional && a->landmark_count == b->landmark_count;
+	return result;
+}
+
+void fitness_cache_clear(FitnessCache *cache, PathFindOptions *options, int step_count)
+{
+	mem_zero((void *)cache->slots, FITNESS_CACHE_SLOT_COUNT * sizeof(*cache->slots));
+
+	cache->entry_count   = 0;
+	cache->options       = *options;
+	cache->options.stats = NULL;
+	cache->step_count    = step_count;
+}
+
+// Slot words are (tag << 32) | score, the tag is never 0 so that an empty slot matches no layout
+int64_t fitness_cache_get_tag(uint64_t hash)
+{
+	int64_t result = (int64_t)((hash >> 32) | 1) << 32;
+	return result;
+}
+
+bool fitness_cache_get(FitnessCache *cache, uint64_t hash, int *score)
+{
+	int64_t tag = fitness_cache_get_tag(hash);
+
+	bool result = false;
+	for(int probe_idx = 0; probe_idx < FITNESS_CACHE_MAX_PROBE_COUNT; ++probe_idx)
+	{
+		int64_t slot = cache->slots[(hash + probe_idx) & (FITNESS_CACHE_SLOT_COUNT - 1)];
+		if(slot == 0)
+		{
+			break;
+		}
+
+		if((slot & 0xFFFFFFFF00000000ll) == tag)
+		{
+			*score = (int)(uint32_t)slot;
+			result = true;
+			break;
+		}
+	}
+
+	return result;
+}
+
+// Lost races are harmless, two threads scoring the same layout write the same word. Entries that find no free
+// slot within the probe limit are dropped
+void fitness_cache_put(FitnessCache *cache, uint64_t hash, int score)
+{
+	int64_t tag   = fitness_cache_get_tag(hash);
+	int64_t entry = tag | (uint32_t)score;
+
+	for(int probe_idx = 0; probe_idx < FITNESS_CACHE_MAX_PROBE_COUNT; ++probe_idx)
+	{
+		volatile int64_t *slot = &cache->slots[(hash + probe_idx) & (FITNESS_CACHE_SLOT_COUNT - 1)];
+
+		int64_t prev_entry = InterlockedCompareExchange64(slot, entry, 0);
+		if(prev_entry == 0)
+		{
+			InterlockedIncrement(&cache->entry_count);
+			break;
+		}
+
+		if((prev_entry & 0xFFFFFFFF00000000ll) == tag)
+		{
+			break;
+		}
+	}
+}
+
+// Shared by the selection tasks. Evaluation cost varies a lot between layouts, so instead of a fixed slice per task each
+// task keeps claiming the next chunk of the population until none is left
+struct SelectionWork
 {
 	AppState *app;
+	Factory  *selected_population; // Same order as the population
 
-	int      population_start;
-	int      population_count;
-	Factory *selected_population;
+	int               chunk_size;
+	volatile uint32_t next_chunk_idx;
+
+	uint64_t busy_microsecs[THREAD_COUNT]; // By work queue thread index, each thread only adds to its own
+};
+
+struct ThreadedSelection
+{
+	SelectionWork *work;
 
 	int min_fitness_score;
 	int max_fitness_score;
+
+	PathFindStats     path_find_stats;
+	FitnessDeltaStats delta_stats;
+
+	int      cache_hit_count;
+	int      cache_miss_count;
+	uint64_t cache_miss_microsecs;
+
+	int pruned_count;
+	int screened_count;
 };
 
-work_queue_callback(threaded_selection)
+void select_factories(ThreadedSelection *selection, int population_start, int population_count)
 {
-	ThreadedSelection *selection = (ThreadedSelection *)user_params;
+	AppState *app = selection->work->app;
 
-	int min_fitness_score = INT_MAX;
-	int max_fitness_score = 0;
+	PathFindOptions options = app->path_find_options;
+	options.stats           = &selection->path_find_stats;
+
+	FitnessCache *cache      = &app->fitness_cache;
+	Factory      *population = &app->population[population_start];
+
+	// Layouts scored before skip evaluation, the rest are gathered so that get_fitness_scores can still batch them
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	int      *miss_idxs      = arena_push_array(scratch.arena, population_count, int);
+	Factory  *misses         = arena_push_array(scratch.arena, population_count, Factory);
+	int       miss_count     = 0;
+	int       screened_count = 0;
+
+	for(int factory_idx = 0; factory_idx < population_count; ++factory_idx)
+	{
+		Factory *factory = &population[factory_idx];
+
+		// A cached score is exact, screened factories without one keep their surrogate score
+		factory->is_fitness_bound = false;
+		if(fitness_cache_get(cache, factory->hash, &factory->fitness_score))
+		{
+			factory->is_fitness_estimate = false;
+		}else if(factory->is_fitness_estimate)
+		{
+			screened_count++;
+		}else
+		{
+			miss_idxs[miss_count] = factory_idx;
+			misses[miss_count++]  = *factory;
+		}
+	}
+
+	uint64_t eval_start = time_get_microsecs();
+
+	get_fitness_scores(app, misses, miss_count, &options, &selection->delta_stats, app->fitness_cutoff_score);
+
+	selection->cache_miss_microsecs += time_get_microsecs() - eval_start;
+	selection->cache_miss_count     += miss_count;
+	selection->cache_hit_count      += population_count - miss_count - screened_count;
+	selection->screened_count       += screened_count;
+
+	// Whole factories, the delta evaluation modes also update the stored pair distances
+	for(int miss_idx = 0; miss_idx < miss_count; ++miss_idx)
+	{
+		Factory *factory = &population[miss_idxs[miss_idx]];
+
+		*factory = misses[miss_idx];
+		if(factory->is_fitness_bound)
+		{
+			selection->pruned_count++;
+		}else
+		{
+			fitness_cache_put(cache, factory->hash, factory->fitness_score);
+		}
+	}
 
-	int selected_population_count = 0;
-	for(int factory_idx = selection->population_start; factory_idx < selection->population_start + selection->population_count; ++factory_idx)
+	arena_end_scratch(scratch);
+
+	for(int factory_idx = population_start; factory_idx < population_start + population_count; ++factory_idx)
 	{
-		Factory *factory = &selection->app->population[factory_idx];
+		Factory *factory = &app->population[factory_idx];
+
+		selection->min_fitness_score = min(factory->fitness_score, selection->min_fitness_score);
+		selection->max_fitness_score = max(factory->fitness_score, selection->max_fitness_score);
+
+		selection->work->selected_population[factory_idx] = *factory;
+	}
+}
+
+work_queue_callback(threaded_selection)
+{
+	ThreadedSelection *selection = (ThreadedSelection *)user_params;
+	SelectionWork     *work      = selection->work;
 
-		factory->fitness_score = get_fitness_score(selection->app, factory);
+	uint64_t busy_start = time_get_microsecs();
 
-		selection->min_fitness_score = min(factory->fitness_score, min_fitness_score);
-		selection->max_fitness_score = max(factory->fitness_score, max_fitness_score);
+	int population_start = (InterlockedIncrement(&work->next_chunk_idx) - 1) * work->chunk_size;
+	while(population_start < work->app->population_count)
+	{
+		select_factories(selection, population_start, min(work->chunk_size, work->app->population_count - population_start));
 
-		selection->selected_population[selected_population_count++] = *factory;
+		population_start = (InterlockedIncrement(&work->next_chunk_idx) - 1) * work->chunk_size;
 	}
+
+	work->busy_microsecs[thread_idx] += time_get_microsecs() - busy_start;
 }
 
 struct ThreadedCrossover
@@ -501,6 +2210,27 @@ work_queue_callback(threaded_crossover)
 
 		if(child_factory.station_count == DESIRED_STATION_COUNT)
 		{
+			// Starting from the fitter parent's distances, the child's delta evaluation searches the pairs its other stations changed
+			child_factory.pair_distances_stamp = parent_factory0->pair_distances_stamp;
+			child_factory.pair_distances_idx   = parent_factory0->pair_distances_idx;
+
+			// Same for the parent's HPA* graph, the child rebuilds the clusters under the stations it took from the other parent
+			child_factory.dirty_clusters  = parent_factory0->dirty_clusters;
+			child_factory.hpa_graph_stamp = parent_factory0->hpa_graph_stamp;
+			child_factory.hpa_graph_idx   = parent_factory0->hpa_graph_idx;
+
+			for(int station_idx = 0; station_idx < child_factory.station_count; ++station_idx)
+			{
+				Station *station        = &child_factory.stations[station_idx];
+				Station *parent_station = &parent_factory0->stations[station_idx];
+
+				if(station->x0 != parent_station->x0 || station->y0 != parent_station->y0 || station->x1 != parent_station->x1 || station->y1 != parent_station->y1)
+				{
+					hpa_add_touched_clusters(&child_factory.dirty_clusters, parent_station->x0, parent_station->y0, parent_station->x1, parent_station->y1);
+					hpa_add_touched_clusters(&child_factory.dirty_clusters, station->x0, station->y0, station->x1, station->y1);
+				}
+			}
+
 			crossover->next_population[crossover->next_population_count++] = child_factory;
 
 			while(crossover->shared_population_count < DESIRED_POPULATION_COUNT)
@@ -577,40 +2307,183 @@ void app_update(AppState *app, InputState *input, WorkQueue *work_queue, Arena *
 	{
 		app->step_count = min(app->step_count + 1, MAX_STEP_COUNT);
 	}
+	PathFindOptions *path_find_options = &app->path_find_options;
+	if(input->keys[KEY_UP].pressed)
+	{
+		path_find_options->mode = (PathFindMode)((path_find_options->mode + 1) % PATH_FIND_MODE_COUNT);
+	}
+	if(input->keys[KEY_DOWN].pressed)
+	{
+		path_find_options->mode = (PathFindMode)((path_find_options->mode + PATH_FIND_MODE_COUNT - 1) % PATH_FIND_MODE_COUNT);
+	}
+	if(input->keys[KEY_SPACE].pressed)
+	{
+		path_find_options->queue = (PathFindQueue)((path_find_options->queue + 1) % PATH_FIND_QUEUE_COUNT);
+	}
+	if(input->keys[KEY_RETURN].pressed)
+	{
+		path_find_options->bidirectional = !path_find_options->bidirectional;
+	}
+	if(input->keys[KEY_TAB].pressed)
+	{
+		path_find_options->policy = (PathFindPolicy)((path_find_options->policy + 1) % PATH_FIND_POLICY_COUNT);
+	}
+	if(input->keys[KEY_F4].pressed)
+	{
+		app->is_surrogate_screening = !app->is_surrogate_screening;
+	}
+	if(input->keys[KEY_F5].pressed)
+	{
+		bench_run(app);
+	}
 
-	ThreadedSelection selections[THREAD_COUNT] = {};
+	// Only between generations, the selection threads read and fill the cache without locks
+	FitnessCache *fitness_cache = &app->fitness_cache;
+	int fitness_step_count = get_fitness_step_count(app);
+	if(!path_find_options_match(&fitness_cache->options, path_find_options) || fitness_cache->step_count != fitness_step_count ||
+	   fitness_cache->entry_count > FITNESS_CACHE_MAX_ENTRY_COUNT)
+	{
+		fitness_cache_clear(fitness_cache, path_find_options, fitness_step_count);
+	}
 
-	Factory *unsorted_selected_population = arena_push_array(transient_arena, app->population_count, Factory);
+	app->hpa_graph_count      = 0;
+	app->pair_distances_count = 0;
 
-	int population_count_per_thread = app->population_count / THREAD_COUNT;
-	int population_count_remainder  = app->population_count % THREAD_COUNT;
+	uint64_t fitness_eval_start = time_get_microsecs();
 
-	for(int thread_idx = 0; thread_idx < THREAD_COUNT; ++thread_idx)
+	// Surrogate pass over the whole population. With screening on, the factories outside of the surrogate's top search
+	// fraction keep its score and are not searched
+	int64_t *manhattan_sums = arena_push_array(transient_arena, app->population_count, int64_t);
+	for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
 	{
-		ThreadedSelection *selection  = &selections[thread_idx];
-		selection->app                 = app;
-		selection->population_start    = population_count_per_thread * thread_idx;
-		selection->population_count    = population_count_per_thread;
-		selection->selected_population = unsorted_selected_population + selection->population_start;
+		manhattan_sums[factory_idx] = get_weighted_manhattan_sum(app, &app->population[factory_idx]);
 
-		if(thread_idx == THREAD_COUNT - 1)
+		app->population[factory_idx].is_fitness_estimate = false;
+	}
+
+	if(app->is_surrogate_screening)
+	{
+		// Ranks count up from the lowest sum, the best surrogate score
+		float *surrogate_ranks = arena_push_array(transient_arena, app->population_count, float);
+		get_ranks(manhattan_sums, app->population_count, surrogate_ranks);
+
+		int search_count = get_surrogate_search_count(app, app->population_count);
+		for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
 		{
-			selection->population_count += population_count_remainder;
+			Factory *factory = &app->population[factory_idx];
+			if(surrogate_ranks[factory_idx] >= search_count)
+			{
+				factory->is_fitness_estimate = true;
+				factory->fitness_score       = get_surrogate_score(app, manhattan_sums[factory_idx]);
+			}
 		}
+	}
+
+	Factory *unsorted_selected_population = arena_push_array(transient_arena, app->population_count, Factory);
+
+	// One factory per claim, or one lockstep sweep's worth
+	SelectionWork selection_work       = {};
+	selection_work.app                 = app;
+	selection_work.selected_population = unsorted_selected_population;
+	selection_work.chunk_size          = path_find_options->mode == PATH_FIND_MODE_LOCKSTEP ? FITNESS_LOCKSTEP_LANE_COUNT : 1;
+
+	ThreadedSelection selections[THREAD_COUNT] = {};
+
+	uint64_t selection_start = time_get_microsecs();
+
+	for(int thread_idx = 0; thread_idx < THREAD_COUNT; ++thread_idx)
+	{
+		ThreadedSelection *selection = &selections[thread_idx];
+		selection->work              = &selection_work;
+		selection->min_fitness_score = INT_MAX;
+		selection->max_fitness_score = INT_MIN;
 
 		work_queue_push_work(work_queue, threaded_selection, selection);
 	}
 
 	work_queue_work_until_done(work_queue, 0);
 
+	// Time each thread spent outside of selection tasks while the generation waited on them
+	uint64_t selection_microsecs = time_get_microsecs() - selection_start;
+	for(int thread_idx = 0; thread_idx < THREAD_COUNT; ++thread_idx)
+	{
+		app->fitness_thread_idle_microsecs[thread_idx] = selection_microsecs - min(selection_work.busy_microsecs[thread_idx], selection_microsecs);
+	}
+
+	app->fitness_eval_microsecs = time_get_microsecs() - fitness_eval_start;
+
 	int min_fitness_score = INT_MAX;
 	int max_fitness_score = 0;
+
+	int      cache_miss_count     = 0;
+	uint64_t cache_miss_microsecs = 0;
+
+	FitnessDeltaStats delta_stats = {};
+
+	app->fitness_pruned_count     = 0;
+	app->surrogate_screened_count = 0;
+
+	app->path_find_stats            = {};
+	app->fitness_cache_lookup_count = app->population_count;
+	app->fitness_cache_hit_count    = 0;
 	for(int thread_idx = 0; thread_idx < THREAD_COUNT; ++thread_idx)
 	{
 		ThreadedSelection *selection = &selections[thread_idx];
 
 		min_fitness_score = min(selection->min_fitness_score, min_fitness_score);
 		max_fitness_score = max(selection->max_fitness_score, max_fitness_score);
+
+		app->fitness_cache_hit_count += selection->cache_hit_count;
+		cache_miss_count             += selection->cache_miss_count;
+		cache_miss_microsecs         += selection->cache_miss_microsecs;
+
+		delta_stats.pair_count          += selection->delta_stats.pair_count;
+		delta_stats.searched_pair_count += selection->delta_stats.searched_pair_count;
+		delta_stats.full_eval_count     += selection->delta_stats.full_eval_count;
+
+		app->fitness_pruned_count     += selection->pruned_count;
+		app->surrogate_screened_count += selection->screened_count;
+
+		path_find_stats_add(&app->path_find_stats, &selection->path_find_stats);
+	}
+
+	app->fitness_delta_stats = delta_stats;
+
+	// The detour is learned from the factories with a searched score, and their surrogate ranking is checked against it.
+	// With screening on these are the surrogate's top, which makes for a narrower sample
+	int64_t *sample_sums   = arena_push_array(transient_arena, app->population_count, int64_t);
+	int64_t *sample_scores = arena_push_array(transient_arena, app->population_count, int64_t);
+	int      sample_count  = 0;
+
+	int64_t distance_sum  = 0;
+	int64_t manhattan_sum = 0;
+	for(int factory_idx = 0; factory_idx < app->population_count; ++factory_idx)
+	{
+		Factory *factory = &app->population[factory_idx];
+		if(!factory->is_fitness_estimate && !factory->is_fitness_bound)
+		{
+			// Negated so that both count up towards the better factory
+			sample_sums  [sample_count] = -manhattan_sums[factory_idx];
+			sample_scores[sample_count] = factory->fitness_score;
+			sample_count++;
+
+			distance_sum  += 1000000 - factory->fitness_score;
+			manhattan_sum += manhattan_sums[factory_idx];
+		}
+	}
+
+	if(manhattan_sum > 0)
+	{
+		app->surrogate_detour = (float)distance_sum / manhattan_sum;
+	}
+	app->surrogate_rank_correlation = get_rank_correlation(sample_sums, sample_scores, sample_count);
+	app->surrogate_sample_count     = sample_count;
+
+	// Thread time, the wall time saved shrinks with the number of threads that were busy
+	app->fitness_cache_saved_microsecs = 0;
+	if(cache_miss_count > 0)
+	{
+		app->fitness_cache_saved_microsecs = cache_miss_microsecs * app->fitness_cache_hit_count / cache_miss_count;
 	}
 
 	int selected_population_count = app->population_count;
@@ -636,6 +2509,28 @@ void app_update(AppState *app, InputState *input, WorkQueue *work_queue, Arena *
 	Factory *selected_population = arena_push_array(transient_arena, selected_population_count, Factory);
 	merge_sort_factories(selected_population, unsorted_selected_population, selected_population_count);
 
+	// Median of the searched scores only, a pruned factory's bound and a screened factory's estimate are not scores
+	int exact_count = 0;
+	for(int factory_idx = 0; factory_idx < selected_population_count; ++factory_idx)
+	{
+		Factory *factory = &selected_population[factory_idx];
+		exact_count += !factory->is_fitness_estimate && !factory->is_fitness_bound;
+	}
+
+	int exact_idx = 0;
+	for(int factory_idx = 0; factory_idx < selected_population_count; ++factory_idx)
+	{
+		Factory *factory = &selected_population[factory_idx];
+		if(!factory->is_fitness_estimate && !factory->is_fitness_bound)
+		{
+			if(exact_idx == exact_count / 2)
+			{
+				app->fitness_cutoff_score = factory->fitness_score;
+			}
+			exact_idx++;
+		}
+	}
+
 	Factory *next_population_threaded = arena_push_array(transient_arena, DESIRED_POPULATION_COUNT, Factory);
 
 	int desired_population_count_per_thread = DESIRED_POPULATION_COUNT / THREAD_COUNT;
@@ -688,27 +2583,11 @@ void app_update(AppState *app, InputState *input, WorkQueue *work_queue, Arena *
 			int mutation_chance = random(&app->rng_seed) % 100;
 			if(mutation_chance < 6)
 			{
-				Station new_station = *station;
-
 				int shift_x_count = (random(&app->rng_seed) % 4) - 2;
 				int shift_y_count = (random(&app->rng_seed) % 4) - 2;
 
-				new_station.x0 = station->x0 + shift_x_count;
-				new_station.y0 = station->y0 + shift_y_count;
-
-				new_station.x1 = station->x1 + shift_x_count;
-				new_station.y1 = station->y1 + shift_y_count;
-
 #if 1
-				write_to_map(factory, station, 0);
-				if(!test_overlap(factory, &new_station))
-				{
-					write_to_map(factory, &new_station, 1);
-					*station = new_station;
-				}else
-				{
-					write_to_map(factory, station, 1);
-				}
+				move_station(factory, station, shift_x_count, shift_y_count);
 #endif
 			}
 		}
@@ -719,7 +2598,14 @@ void app_update(AppState *app, InputState *input, WorkQueue *work_queue, Arena *
 		Factory *dst = &app->population[factory_idx];
 		Factory *src = &next_population[factory_idx];
 
-		mem_copy_array(dst->map,      MAP_W * MAP_H,      src->map,      MAP_W * MAP_H);
+		dst->map  = src->map;
+		dst->hash = src->hash;
+
+		dst->dirty_clusters       = src->dirty_clusters;
+		dst->hpa_graph_stamp      = src->hpa_graph_stamp;
+		dst->hpa_graph_idx        = src->hpa_graph_idx;
+		dst->pair_distances_stamp = src->pair_distances_stamp;
+		dst->pair_distances_idx   = src->pair_distances_idx;
 		mem_copy_array(dst->stations, dst->station_count, src->stations, src->station_count);
 
 		dst->station_count = src->station_count;
@@ -759,6 +2645,13 @@ void app_update(AppState *app, InputState *input, WorkQueue *work_queue, Arena *
 		target->y = station->y0 + station->door_offset_y;
 	}
 
+	// HPA* draws on the graph get_fitness_score_hpa left for the factory this generation, when it was evaluated
+	HpaGraph *hpa_graph = NULL;
+	if(path_find_options->mode == PATH_FIND_MODE_HPA && factory->hpa_graph_stamp > 0 && factory->hpa_graph_stamp == app->generation_count + 1)
+	{
+		hpa_graph = &app->hpa_graphs[app->generation_count % 2][factory->hpa_graph_idx];
+	}
+
 	for(int station_idx = 0; station_idx < factory->station_count; ++station_idx)
 	{
 		Station *station = &factory->stations[station_idx];
@@ -772,8 +2665,15 @@ void app_update(AppState *app, InputState *input, WorkQueue *work_queue, Arena *
 			step_count = app->step_count;
 		}
 
-		int target_offset = station_idx + 1;
-		FoundPaths paths  = path_find_targets(factory->map, start_x, start_y, targets + target_offset, target_count - target_offset, step_count, transient_arena);
+		int        target_offset = station_idx + 1;
+		FoundPaths paths         = {};
+		if(hpa_graph)
+		{
+			paths = hpa_path_find_targets(hpa_graph, &factory->map, start_x, start_y, targets + target_offset, target_count - target_offset, step_count, transient_arena);
+		}else
+		{
+			paths = path_find_targets(&factory->map, start_x, start_y, targets + target_offset, target_count - target_offset, step_count, transient_arena, path_find_options);
+		}
 
 		for(int path_idx = 0; path_idx < paths.count; ++path_idx)
 		{
@@ -836,5 +2736,79 @@ void app_update(AppState *app, InputState *input, WorkQueue *work_queue, Arena *
 	stbsp_snprintf(text, sizeof(text), "Fitness Score: %d", factory->fitness_score);
 	draw_text(&app->font, 0, app->baseline, 1, 1, 1, text);
 	app->baseline += app->font.baseline_advance;
+
+	stbsp_snprintf(text, sizeof(text), "Path Find Mode: %s (%s queue%s), %s Policy", path_find_mode_name(path_find_options->mode), path_find_queue_name(path_find_options->queue), path_find_options->bidirectional ? ", bidirectional" : "", path_find_policy_name(path_find_options->policy));
+	draw_text(&app->font, 0, app->baseline, 1, 1, 1, text);
+	app->baseline += app->font.baseline_advance;
+
+	stbsp_snprintf(text, sizeof(text), "Fitness Eval: %.2fms, %llu searches, %llu expanded, %.2fMB cleared", app->fitness_eval_microsecs / 1000.0f, app->path_find_stats.search_count, app->path_find_stats.expanded_node_count, app->path_find_stats.cleared_byte_count / (1024.0f * 1024.0f));
+	draw_text(&app->font, 0, app->baseline, 1, 1, 1, text);
+	app->baseline += app->font.baseline_advance;
+
+	float cache_hit_percent = 100.0f * app->fitness_cache_hit_count / max(app->fitness_cache_lookup_count, 1);
+	stbsp_snprintf(text, sizeof(text), "Fitness Cache: %d/%d hits (%.1f%%), ~%.2fms thread time saved, %u entries", app->fitness_cache_hit_count, app->fitness_cache_lookup_count, cache_hit_percent, app->fitness_cache_saved_microsecs / 1000.0f, app->fitness_cache.entry_count);
+	draw_text(&app->font, 0, app->baseline, 1, 1, 1, text);
+	app->baseline += app->font.baseline_advance;
+
+	if(path_find_mode_has_cutoff(path_find_options->mode) && app->fitness_cutoff_score > INT_MIN)
+	{
+		stbsp_snprintf(text, sizeof(text), "Fitness Cutoff: %d, %d/%d pruned", app->fitness_cutoff_score, app->fitness_pruned_count, app->fitness_cache_lookup_count);
+		draw_text(&app->font, 0, app->baseline, 1, 1, 1, text);
+		app->baseline += app->font.baseline_advance;
+	}
+
+	int text_length = stbsp_snprintf(text, sizeof(text), "Thread Idle:");
+	for(int thread_idx = 0; thread_idx < THREAD_COUNT; ++thread_idx)
+	{
+		text_length += stbsp_snprintf(text + text_length, sizeof(text) - text_length, " %.2fms", app->fitness_thread_idle_microsecs[thread_idx] / 1000.0f);
+	}
+	draw_text(&app->font, 0, app->baseline, 1, 1, 1, text);
+	app->baseline += app->font.baseline_advance;
+
+	stbsp_snprintf(text, sizeof(text), "Surrogate: %s, top %d%% searched, %d screened, detour x%.3f, rank correlation %.3f over %d", app->is_surrogate_screening ? "screening" : "off", (int)(100 * app->surrogate_search_fraction + 0.5f), app->surrogate_screened_count, app->surrogate_detour, app->surrogate_rank_correlation, app->surrogate_sample_count);
+	draw_text(&app->font, 0, app->baseline, 1, 1, 1, text);
+	app->baseline += app->font.baseline_advance;
+
+	if(path_find_mode_has_delta(path_find_options->mode))
+	{
+		FitnessDeltaStats *delta_stats = &app->fitness_delta_stats;
+
+		float searched_pair_percent = 100.0f * delta_stats->searched_pair_count / max(delta_stats->pair_count, 1);
+		stbsp_snprintf(text, sizeof(text), "Delta Eval: %llu/%llu pairs searched (%.1f%%), %llu full evaluations", delta_stats->searched_pair_count, delta_stats->pair_count, searched_pair_percent, delta_stats->full_eval_count);
+		draw_text(&app->font, 0, app->baseline, 1, 1, 1, text);
+		app->baseline += app->font.baseline_advance;
+	}
+
+	// Results of the last F5 benchmark over the population
+	for(int result_idx = 0; result_idx < app->bench_result_count; ++result_idx)
+	{
+		BenchResult *result = &app->bench_results[result_idx];
+
+		float expansions_per_microsec = result->microsecs ? (float)result->stats.expanded_node_count / result->microsecs : 0;
+
+		if(result->query_count)
+		{
+			float queries_per_sec = result->microsecs ? result->query_count * 1000000.0f / result->microsecs : 0;
+
+			stbsp_snprintf(text, sizeof(text), "Bench %s: %.2fms, %llu queries (%.0fK/s), %llu expanded, score sum %lld", result->name, result->microsecs / 1000.0f, result->query_count, queries_per_sec / 1000.0f, result->stats.expanded_node_count, result->score_sum);
+		}else if(result->has_mismatch_count)
+		{
+			stbsp_snprintf(text, sizeof(text), "Bench %s: %.2fms, %llu expanded, %d door pairs differ from the heap, score sum %lld", result->name, result->microsecs / 1000.0f, result->stats.expanded_node_count, result->mismatch_count, result->score_sum);
+		}else if(result->has_rank_correlation)
+		{
+			stbsp_snprintf(text, sizeof(text), "Bench %s: %.2fms, rank correlation %.3f, %d/%d of the searched top kept, score sum %lld", result->name, result->microsecs / 1000.0f, result->rank_correlation, result->top_overlap_count, result->top_count, result->score_sum);
+		}else if(result->has_length_excess)
+		{
+			int64_t exact_length_sum = result->score_sum - result->length_excess_sum;
+			float   excess_percent   = exact_length_sum ? 100.0f * result->length_excess_sum / exact_length_sum : 0;
+
+			stbsp_snprintf(text, sizeof(text), "Bench %s: %.2fms, %llu expanded (%.1fM/s), length sum %lld (+%.2f%%, worst +%d)", result->name, result->microsecs / 1000.0f, result->stats.expanded_node_count, expansions_per_microsec, result->score_sum, excess_percent, result->length_excess_max);
+		}else
+		{
+			stbsp_snprintf(text, sizeof(text), "Bench %s: %.2fms, %llu expanded (%.1fM/s), %.2fMB cleared, score sum %lld", result->name, result->microsecs / 1000.0f, result->stats.expanded_node_count, expansions_per_microsec, result->stats.cleared_byte_count / (1024.0f * 1024.0f), result->score_sum);
+		}
+		draw_text(&app->font, 0, app->baseline, 1, 1, 1, text);
+		app->baseline += app->font.baseline_advance;
+	}
 }
 
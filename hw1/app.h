@@ -15,6 +15,12 @@ const int MAX_STEP_COUNT = 1024;
 
 const int THREAD_COUNT = 4;
 
+// Lanes per lockstep sweep in fitness evaluation, the fastest width in the F5 lockstep rows. Wider sweeps run every lane
+// until the slowest one is done and lose more to that than they gain from vectorizing
+const int FITNESS_LOCKSTEP_LANE_COUNT = 1;
+
+const int MAX_BENCH_RESULT_COUNT = 64;
+
 struct Font
 {
 	float  baseline_advance;
@@ -54,14 +60,92 @@ struct Station
 	int door_offset_y;
 };
 
+const int DOOR_PAIR_COUNT = DESIRED_STATION_COUNT * (DESIRED_STATION_COUNT - 1) / 2;
+
+// Door distances and path footprints of the last evaluation and the station rectangles they were found on, so that the
+// next evaluation only searches the pairs a change could have affected (see get_fitness_score_delta). The modes that
+// fill it agree on every distance, so it stays valid across mode switches. Only some trace footprints, pairs without
+// one fall back to a looser test.
+struct PairDistances
+{
+	int      station_count;
+	int      step_count;
+	MapRect  rects[DESIRED_STATION_COUNT];
+	uint16_t      distances[DOOR_PAIR_COUNT];  // FoundPath::tile_count of the upper triangle, row-major
+	PathFootprint footprints[DOOR_PAIR_COUNT]; // One path per pair where the search traced one
+};
+
+struct FitnessDeltaStats
+{
+	uint64_t pair_count;          // Door pairs scored
+	uint64_t searched_pair_count; // Pairs that were searched again, the rest kept their distance
+	uint64_t full_eval_count;     // Factories evaluated in full, on first sight or when the delta would cost more
+};
+
 struct Factory
 {
-	MapTile map[MAP_W * MAP_H];
+	OccupancyMap map;
 
 	int     station_count;
 	Station stations[DESIRED_STATION_COUNT];
 
-	int fitness_score;
+	int  fitness_score;
+	bool is_fitness_bound;    // fitness_score is only an upper bound of a factory pruned by the cutoff, see get_fitness_score
+	bool is_fitness_estimate; // fitness_score is the surrogate's, the factory was screened out without a search
+
+	uint64_t hash; // Zobrist hash of the placed stations, write_to_map toggles each station's key in and out
+
+	// HPA* graph of the factory's last evaluation, or of the parent it was bred from, see get_fitness_score_hpa. The
+	// stamp is the generation_count + 1 that claimed AppState::hpa_graphs[hpa_graph_idx], 0 for none
+	HpaClusterSet dirty_clusters; // Clusters write_to_map touched since that graph was updated
+	int           hpa_graph_stamp;
+	int           hpa_graph_idx;
+
+	// Same for the door distances of the delta evaluation in AppState::pair_distances, see get_fitness_score_delta
+	int pair_distances_stamp;
+	int pair_distances_idx;
+};
+
+// Fitness scores by Factory::hash, shared by the selection threads. Open addressing with linear probing, each slot is
+// one word holding the upper hash bits and the score so that a reader never sees half an entry. The lower hash bits
+// pick the slot, which leaves 47 bits to tell layouts apart
+const int FITNESS_CACHE_SLOT_COUNT       = 1 << 16;
+const int FITNESS_CACHE_MAX_PROBE_COUNT  = 32;
+const int FITNESS_CACHE_MAX_ENTRY_COUNT  = FITNESS_CACHE_SLOT_COUNT / 2; // Cleared between generations beyond this
+
+struct FitnessCache
+{
+	volatile int64_t  *slots;
+	volatile uint32_t  entry_count;
+
+	PathFindOptions options;    // Scores were computed with these and this step count, a change to either clears the cache
+	int             step_count;
+};
+
+struct BenchResult
+{
+	char name[64];
+
+	uint64_t      microsecs;
+	int64_t       score_sum; // Sum of fitness scores so configurations can be checked for agreement
+	PathFindStats stats;
+
+	uint64_t query_count; // Source to target queries, batch and delta update benches only
+
+	// Search policy benches only, how much longer the found paths are than the shortest ones
+	bool    has_length_excess;
+	int64_t length_excess_sum;
+	int     length_excess_max;
+
+	// Surrogate bench only, how well the surrogate ranks the population against the searched scores
+	bool  has_rank_correlation;
+	float rank_correlation;
+	int   top_count;         // Factories the surrogate would send to search
+	int   top_overlap_count; // Of those, how many are also in the searched top
+
+	// Queue agreement bench only, door pairs whose capped distance differs from A* on the heap
+	bool has_mismatch_count;
+	int  mismatch_count;
 };
 
 struct AppState
@@ -80,6 +164,44 @@ struct AppState
 	int generation_count;
 
 	int step_count;
+
+	PathFindOptions path_find_options;
+	PathFindStats   path_find_stats;        // Accumulated over the last generation's fitness evaluation
+	uint64_t        fitness_eval_microsecs; // Wall time of the last generation's fitness evaluation
+
+	uint64_t fitness_thread_idle_microsecs[THREAD_COUNT]; // By work queue thread index, waiting while selection tasks ran
+
+	// Last generation's cache use. The saving is the hit count times the average cost of a miss
+	FitnessCache fitness_cache;
+	int          fitness_cache_lookup_count;
+	int          fitness_cache_hit_count;
+	uint64_t     fitness_cache_saved_microsecs;
+
+	FitnessDeltaStats fitness_delta_stats; // Last generation, delta evaluation modes only
+
+	// HPA* graphs of the current and the last generation by generation_count parity, each evaluation claims the next one
+	// of the current generation. The last generation's graphs are what the factories bred from them start with
+	HpaGraph          *hpa_graphs[2];
+	volatile uint32_t  hpa_graph_count;
+
+	// Same for the door distances of the delta evaluation modes
+	PairDistances     *pair_distances[2];
+	volatile uint32_t  pair_distances_count;
+
+	int fitness_cutoff_score; // Median score of the last generation, factories that can not reach it stop evaluating
+	int fitness_pruned_count; // Last generation
+
+	// Two-stage evaluation, the surrogate ranks the population and only the top search fraction is searched. The detour
+	// and the correlation come from the last generation's factories with a searched score, whether screening is on or not
+	bool  is_surrogate_screening;
+	float surrogate_search_fraction;
+	float surrogate_detour;           // Weighted door distance over weighted Manhattan distance
+	float surrogate_rank_correlation; // Spearman, surrogate against searched scores
+	int   surrogate_sample_count;
+	int   surrogate_screened_count;
+
+	int         bench_result_count;
+	BenchResult bench_results[MAX_BENCH_RESULT_COUNT];
 };
 
 Font load_font(const char *filename);
@@ -87,7 +209,17 @@ Font load_font(const char *filename);
 void draw_text(Font *font, float x, float y, float r, float g, float b, char *text);
 void draw_rect(float x, float y, float w, float h, float r, float g, float b);
 
-Factory generate_factory(AppState *app, Arena *arena);
+Factory generate_factory(AppState *app, unsigned int *rng_seed);
+
+int  get_fitness_score (AppState *app, Factory *factory, PathFindOptions *options, int cutoff_score = INT_MIN, bool *is_pruned = NULL);
+void get_fitness_scores(AppState *app, Factory *factories, int factory_count, PathFindOptions *options, FitnessDeltaStats *delta_stats = NULL, int cutoff_score = INT_MIN);
+
+int64_t get_weighted_manhattan_sum(AppState *app, Factory *factory);
+int     get_surrogate_score       (AppState *app, int64_t weighted_manhattan_sum);
+int     get_surrogate_search_count(AppState *app, int factory_count);
+
+void bench_path_find(AppState *app, PathFindOptions *options);
+void bench_run      (AppState *app);
 
-AppState app_make  (const char *font_filename, unsigned int rng_seed, Arena *permanent_arena);
+AppState app_make  (const char *font_filename, unsigned int rng_seed, WorkQueue *work_queue, Arena *permanent_arena);
 void     app_update(AppState *app, InputState *input, WorkQueue *work_queue, Arena *transient_arena);
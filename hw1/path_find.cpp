@@ -1,24 +1,316 @@
 #include "path_find.h"
 
-void grid_node_set_h(GridNode *node, int target_x, int target_y)
+const char *path_find_mode_name(PathFindMode mode)
+{
+	const char *names[] = {
+		"A*",
+		"Flood",
+		"JPS",
+		"Bits",
+		"Multi-Source",
+		"A* (SoA)",
+		"HPA*",
+		"Visibility",
+		"Lockstep",
+		"ALT",
+	};
+	static_assert(array_count(names) == PATH_FIND_MODE_COUNT);
+
+	const char *result = "Unknown";
+	if(mode >= 0 && mode < PATH_FIND_MODE_COUNT)
+	{
+		result = names[mode];
+	}
+
+	return result;
+}
+
+const char *path_find_queue_name(PathFindQueue queue)
+{
+	const char *names[] = {
+		"Heap",
+		"Bucket",
+	};
+	static_assert(array_count(names) == PATH_FIND_QUEUE_COUNT);
+
+	const char *result = "Unknown";
+	if(queue >= 0 && queue < PATH_FIND_QUEUE_COUNT)
+	{
+		result = names[queue];
+	}
+
+	return result;
+}
+
+const char *path_find_policy_name(PathFindPolicy policy)
+{
+	const char *names[] = {
+		"Optimal",
+		"Weighted",
+		"Greedy",
+	};
+	static_assert(array_count(names) == PATH_FIND_POLICY_COUNT);
+
+	const char *result = "Unknown";
+	if(policy >= 0 && policy < PATH_FIND_POLICY_COUNT)
+	{
+		result = names[policy];
+	}
+
+	return result;
+}
+
+void path_find_stats_add(PathFindStats *dst, PathFindStats *src)
+{
+	dst->search_count        += src->search_count;
+	dst->expanded_node_count += src->expanded_node_count;
+	dst->cleared_byte_count  += src->cleared_byte_count;
+}
+
+// Set bits are free tiles
+void map_bits_from_occupancy(MapBits *bits, OccupancyMap *map)
+{
+	for(int y = 0; y < MAP_H; ++y)
+	{
+		for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+		{
+			bits->rows[y][word_idx] = ~map->rows[y][word_idx];
+		}
+	}
+}
+
+bool map_bits_test(MapBits *bits, int x, int y)
+{
+	bool result = (bits->rows[y][x / 64] >> (x % 64)) & 1;
+	return result;
+}
+
+// True for blocked tiles. Callers check bounds, the unsigned division saves the sign fix-up of x / 64 and x % 64
+bool occupancy_test(OccupancyMap *map, int x, int y)
+{
+	uint32_t column = (uint32_t)x;
+
+	bool result = (map->rows[y][column / 64] >> (column % 64)) & 1;
+	return result;
+}
+
+// The bits of word word_idx that lie in columns x0 to x1 (exclusive)
+uint64_t map_row_get_mask(int word_idx, int x0, int x1)
+{
+	int bit0 = max(x0 - word_idx * 64, 0);
+	int bit1 = min(x1 - word_idx * 64, 64);
+
+	uint64_t result = 0;
+	if(bit0 < bit1)
+	{
+		result = (~0ull >> (64 - (bit1 - bit0))) << bit0;
+	}
+
+	return result;
+}
+
+// True if any tile of the rectangle is blocked
+bool occupancy_test_rect(OccupancyMap *map, int x0, int y0, int x1, int y1)
+{
+	uint64_t blocked = 0;
+
+	for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+	{
+		uint64_t mask = map_row_get_mask(word_idx, x0, x1);
+		if(mask)
+		{
+			for(int y = y0; y < y1; ++y)
+			{
+				blocked |= map->rows[y][word_idx] & mask;
+			}
+		}
+	}
+
+	bool result = blocked != 0;
+	return result;
+}
+
+void occupancy_write_rect(OccupancyMap *map, int x0, int y0, int x1, int y1, bool is_blocked)
+{
+	for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+	{
+		uint64_t mask = map_row_get_mask(word_idx, x0, x1);
+		if(mask)
+		{
+			for(int y = y0; y < y1; ++y)
+			{
+				if(is_blocked)
+				{
+					map->rows[y][word_idx] |= mask;
+				}else
+				{
+					map->rows[y][word_idx] &= ~mask;
+				}
+			}
+		}
+	}
+}
+
+// Erodes the free tiles by the rectangle, first along the rows with one-column shifts and then down the columns. Bits
+// shifted in from beyond the map count as blocked
+void occupancy_get_free_positions(MapBits *positions, OccupancyMap *map, int w, int h)
+{
+	for(int y = 0; y < MAP_H; ++y)
+	{
+		uint64_t run[MAP_ROW_WORD_COUNT];
+		uint64_t shifted[MAP_ROW_WORD_COUNT];
+
+		for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+		{
+			run[word_idx]     = ~map->rows[y][word_idx];
+			shifted[word_idx] = run[word_idx];
+		}
+
+		for(int column_idx = 1; column_idx < w; ++column_idx)
+		{
+			for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+			{
+				uint64_t next = word_idx + 1 < MAP_ROW_WORD_COUNT ? shifted[word_idx + 1] : 0;
+
+				shifted[word_idx]  = (shifted[word_idx] >> 1) | (next << 63);
+				run[word_idx]     &= shifted[word_idx];
+			}
+		}
+
+		mem_copy_array(positions->rows[y], MAP_ROW_WORD_COUNT, run, MAP_ROW_WORD_COUNT);
+	}
+
+	// Rows below y still hold their runs when row y reads them
+	for(int y = 0; y < MAP_H; ++y)
+	{
+		for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+		{
+			uint64_t bits = 0;
+			if(y + h <= MAP_H)
+			{
+				bits = ~0ull;
+				for(int row_idx = 0; row_idx < h; ++row_idx)
+				{
+					bits &= positions->rows[y + row_idx][word_idx];
+				}
+			}
+
+			positions->rows[y][word_idx] = bits;
+		}
+	}
+}
+
+// Clips to the map, x1 and y1 are exclusive like MapRect
+void map_bits_clear_rect(MapBits *bits, int x0, int y0, int x1, int y1)
+{
+	x0 = max(x0, 0);
+	y0 = max(y0, 0);
+	x1 = min(x1, MAP_W);
+	y1 = min(y1, MAP_H);
+
+	for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+	{
+		uint64_t mask = map_row_get_mask(word_idx, x0, x1);
+		if(mask)
+		{
+			for(int y = y0; y < y1; ++y)
+			{
+				bits->rows[y][word_idx] &= ~mask;
+			}
+		}
+	}
+}
+
+// The set bit of rank (rank % count) in row-major order among the columns below x1 and the rows below y1. False if
+// there is none
+bool map_bits_pick_position(MapBits *bits, int x1, int y1, unsigned int rank, PathTile *position)
+{
+	int count = 0;
+	for(int y = 0; y < y1; ++y)
+	{
+		for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+		{
+			count += (int)__popcnt64(bits->rows[y][word_idx] & map_row_get_mask(word_idx, 0, x1));
+		}
+	}
+
+	bool result = count > 0;
+	if(result)
+	{
+		int remaining = (int)(rank % (unsigned int)count);
+		int y         = 0;
+		int word_idx  = 0;
+
+		// Skip whole words, then clear the lower set bits of the word that holds the pick
+		uint64_t word = bits->rows[0][0] & map_row_get_mask(0, 0, x1);
+		while(remaining >= (int)__popcnt64(word))
+		{
+			remaining -= (int)__popcnt64(word);
+
+			if(++word_idx == MAP_ROW_WORD_COUNT)
+			{
+				word_idx = 0;
+				++y;
+			}
+
+			word = bits->rows[y][word_idx] & map_row_get_mask(word_idx, 0, x1);
+		}
+
+		for(; remaining > 0; --remaining)
+		{
+			word &= word - 1;
+		}
+
+		unsigned long bit_idx = 0;
+		_BitScanForward64(&bit_idx, word);
+
+		position->x = word_idx * 64 + (int)bit_idx;
+		position->y = y;
+	}
+
+	return result;
+}
+
+// Weighted A* inflates h once here so that it orders the open list like the optimal policy. Landmark bounds are
+// consistent like Manhattan distance, so the larger of the two still never closes a node early
+template <PathFindPolicy policy>
+void grid_node_set_h(GridNode *node, int target_x, int target_y, int weight, LandmarkFields *landmarks)
 {
 	int manhattan_x        = abs(target_x - node->x);
 	int manhattan_y        = abs(target_y - node->y);
 	int manhattan_distance = manhattan_x + manhattan_y;
 
+	if(landmarks)
+	{
+		manhattan_distance = max(manhattan_distance, landmark_fields_get_bound(landmarks, node->x, node->y, target_x, target_y));
+	}
+
+	if(policy == PATH_FIND_POLICY_WEIGHTED)
+	{
+		manhattan_distance = (manhattan_distance * weight) >> PATH_FIND_WEIGHT_SHIFT;
+	}
+
 	node->h = manhattan_distance;
 }
 
+template <PathFindPolicy policy>
+int grid_node_get_f(GridNode *node)
+{
+	int result = node->g + node->h;
+	if(policy == PATH_FIND_POLICY_GREEDY)
+	{
+		// Greedy best-first (not optimal path but potentially faster)
+		result = node->h;
+	}
+
+	return result;
+}
+
+template <PathFindPolicy policy>
 int grid_node_cmp(GridNode *a, GridNode *b)
 {
-#if 0
-	// Greedy A* path finding (not optimal path but potentially faster)
-	int a_f = a->h;
-	int b_f = b->h;
-#else
-	int a_f = a->g + a->h;
-	int b_f = b->g + b->h;
-#endif
+	int a_f = grid_node_get_f<policy>(a);
+	int b_f = grid_node_get_f<policy>(b);
 
 	int result = 0;
 	if(a_f == b_f)
@@ -66,15 +358,17 @@ void heap_swap(GridNodeHeap *heap, int a, int b)
 	heap->nodes[b]->heap_idx = b;
 }
 
+template <PathFindPolicy policy>
 void heap_heapify_up(GridNodeHeap *heap, int idx)
 {
-	while(idx > 0 && grid_node_cmp(heap->nodes[get_parent_idx(idx)], heap->nodes[idx]) > 0)
+	while(idx > 0 && grid_node_cmp<policy>(heap->nodes[get_parent_idx(idx)], heap->nodes[idx]) > 0)
 	{
 		heap_swap(heap, get_parent_idx(idx), idx);
 		idx = get_parent_idx(idx);
 	}
 }
 
+template <PathFindPolicy policy>
 void heap_insert(GridNodeHeap *heap, GridNode *node)
 {
 	if(heap->node_count < GRID_NODE_HEAP_CAPACITY)
@@ -83,10 +377,11 @@ void heap_insert(GridNodeHeap *heap, GridNode *node)
 
 		// Insert at bottom of tree
 		heap->nodes[node->heap_idx] = node;
-		heap_heapify_up(heap, node->heap_idx);
+		heap_heapify_up<policy>(heap, node->heap_idx);
 	}
 }
 
+template <PathFindPolicy policy>
 void heap_remove_min(GridNodeHeap *heap)
 {
 	int last_idx = heap->node_count - 1;
@@ -100,12 +395,12 @@ heapify_down:
 
 	int smallest_idx = curr_idx;
 
-	if(l_idx < heap->node_count && grid_node_cmp(heap->nodes[l_idx], heap->nodes[smallest_idx]) < 0)
+	if(l_idx < heap->node_count && grid_node_cmp<policy>(heap->nodes[l_idx], heap->nodes[smallest_idx]) < 0)
 	{
 		smallest_idx = l_idx;
 	}
 
-	if(r_idx < heap->node_count && grid_node_cmp(heap->nodes[r_idx], heap->nodes[smallest_idx]) < 0)
+	if(r_idx < heap->node_count && grid_node_cmp<policy>(heap->nodes[r_idx], heap->nodes[smallest_idx]) < 0)
 	{
 		smallest_idx = r_idx;
 	}
@@ -119,144 +414,3226 @@ heapify_down:
 	}
 }
 
-void push_path(FoundPaths *paths, GridNode *node, Arena *arena)
+GridNodeBuckets buckets_make(Arena *arena)
 {
-	FoundPath *path = &paths->paths[paths->count++];
+	GridNodeBuckets result = {};
+	result.min_bucket      = GRID_NODE_BUCKET_COUNT;
+	result.max_bucket      = -1;
+	result.buckets         = arena_push_array(arena, GRID_NODE_BUCKET_COUNT, GridNode *);
 
-	for(GridNode *n = node; n; n = n->parent)
+	return result;
+}
+
+template <PathFindPolicy policy>
+void buckets_insert(GridNodeBuckets *buckets, GridNode *node)
+{
+	int f = grid_node_get_f<policy>(node);
+	assert(f >= 0 && f < GRID_NODE_BUCKET_COUNT);
+
+	// Ties are broken towards low h like grid_node_cmp, approximately: the node goes to the front of the
+	// list unless the current front is closer to the target, in which case it goes right behind it
+	GridNode **head = &buckets->buckets[f];
+
+	node->heap_idx = f;
+	if(*head && (*head)->h < node->h)
+	{
+		GridNode *prev = *head;
+		node->bucket_prev = prev;
+		node->bucket_next = prev->bucket_next;
+		if(prev->bucket_next)
+		{
+			prev->bucket_next->bucket_prev = node;
+		}
+		prev->bucket_next = node;
+	}else
 	{
-		path->tile_count++;
+		node->bucket_prev = NULL;
+		node->bucket_next = *head;
+		if(*head)
+		{
+			(*head)->bucket_prev = node;
+		}
+		*head = node;
 	}
 
-	path->tiles = arena_push_array(arena, path->tile_count, PathTile);
+	buckets->min_bucket = min(buckets->min_bucket, f);
+	buckets->max_bucket = max(buckets->max_bucket, f);
+	++buckets->node_count;
+}
 
-	int tile_idx = path->tile_count - 1;
-	for(GridNode *n = node; n; n = n->parent)
+void buckets_remove(GridNodeBuckets *buckets, GridNode *node)
+{
+	if(node->bucket_prev)
+	{
+		node->bucket_prev->bucket_next = node->bucket_next;
+	}else
 	{
-		PathTile *tile = &path->tiles[tile_idx--];
-		tile->x             = n->x;
-		tile->y             = n->y;
+		buckets->buckets[node->heap_idx] = node->bucket_next;
 	}
+
+	if(node->bucket_next)
+	{
+		node->bucket_next->bucket_prev = node->bucket_prev;
+	}
+
+	node->bucket_prev = NULL;
+	node->bucket_next = NULL;
+	--buckets->node_count;
 }
 
-FoundPaths path_find_targets(MapTile *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, Arena *arena)
+template <PathFindPolicy policy>
+void buckets_update(GridNodeBuckets *buckets, GridNode *node)
 {
-	FoundPaths result = {};
-	result.paths      = arena_push_array(arena, target_count, FoundPath);
+	buckets_remove(buckets, node);
+	buckets_insert<policy>(buckets, node);
+}
+
+GridNode *buckets_get_min(GridNodeBuckets *buckets)
+{
+	GridNode *result = NULL;
+	if(buckets->node_count > 0)
+	{
+		while(!buckets->buckets[buckets->min_bucket])
+		{
+			++buckets->min_bucket;
+		}
 
-	Arena *conflicts[] = {arena};
-	TmpArena scratch   = arena_begin_scratch(conflicts, array_count(conflicts));
+		result = buckets->buckets[buckets->min_bucket];
+	}
 
-	GridNode *grid_node_map = arena_push_array(scratch.arena, MAP_W * MAP_H, GridNode);
-	GridNode *start_node    = &grid_node_map[start_y * MAP_W + start_x];
+	return result;
+}
 
-	start_node->x      = start_x;
-	start_node->y      = start_y;
-	start_node->opened = true;
+GridNodePool grid_node_pool_make()
+{
+	GridNodePool result = {};
+	result.arena        = arena_make(megabytes(16));
 
-	GridNodeHeap open_list     = heap_make(scratch.arena);
-	GridNodeHeap tmp_open_list = heap_make(scratch.arena);
+	// Zeroed once here, generation 0 is never used by a search
+	result.nodes         = arena_push_array(&result.arena, MAP_W * MAP_H, GridNode);
+	result.reverse_nodes = arena_push_array(&result.arena, MAP_W * MAP_H, GridNode);
+	result.target_stamps = arena_push_array(&result.arena, MAP_W * MAP_H, uint32_t);
 
-	for(int target_idx = 0; target_idx < target_count; ++target_idx)
+	for(int i = 0; i < 2; ++i)
 	{
-		PathTile *target = &targets[target_idx];
-		int target_x = target->x;
-		int target_y = target->y;
+		result.heap_nodes[i] = arena_push_array(&result.arena, GRID_NODE_HEAP_CAPACITY, GridNode *);
+		result.buckets[i]    = arena_push_array(&result.arena, GRID_NODE_BUCKET_COUNT,  GridNode *);
+	}
 
-		if(target_idx == 0)
-		{
-			grid_node_set_h(start_node, target_x, target_y);
-			heap_insert(&open_list, start_node);
-		}else
-		{
-			GridNode *target_node = &grid_node_map[target_y * MAP_W + target_x];
-			if(target_node->closed)
-			{
-				push_path(&result, target_node, arena);
-				continue;
-			}else
-			{
-				mem_zero_array(tmp_open_list.nodes, tmp_open_list.node_count);
-				tmp_open_list.node_count = 0;
+	result.compact_states     = arena_push_array(&result.arena, MAP_W * MAP_H, uint8_t);
+	result.compact_g          = arena_push_array(&result.arena, MAP_W * MAP_H, uint16_t);
+	result.compact_heap_slots = arena_push_array(&result.arena, MAP_W * MAP_H, uint16_t);
+	result.compact_heap       = arena_push_array(&result.arena, MAP_W * MAP_H, uint64_t);
 
-				for(int node_idx = 0; node_idx < open_list.node_count; ++node_idx)
-				{
-					GridNode *node = open_list.nodes[node_idx];
-					grid_node_set_h(node, target_x, target_y);
+	result.hpa_graph        = arena_push_array(&result.arena, 1, HpaGraph);
+	result.hpa_graph_map    = arena_push_array(&result.arena, 1, OccupancyMap);
+	result.visibility_graph = arena_push_array(&result.arena, 1, VisibilityGraph);
+	result.landmark_fields  = arena_push_array(&result.arena, 1, LandmarkFields);
 
-					heap_insert(&tmp_open_list, node);
-				}
+	result.landmark_fields_map = arena_push_array(&result.arena, 1, OccupancyMap);
 
-				swap(open_list, tmp_open_list);
-			}
-		}
+	result.visibility_heap = arena_push_array(&result.arena, VISIBILITY_MAX_NODE_COUNT * VISIBILITY_MAX_NODE_COUNT, uint64_t);
 
-		int step_count = 0;
-		while(open_list.node_count > 0)
-		{
-			GridNode *curr = open_list.nodes[0];
-			heap_remove_min(&open_list);
-			curr->closed = true;
+	result.bits_wave_rows    = arena_push_array(&result.arena, BITS_WAVE_CAPACITY * MAP_H * MAP_ROW_WORD_COUNT, uint64_t);
+	result.bits_wave_offsets = arena_push_array(&result.arena, BITS_WAVE_CAPACITY + 1, int);
+	result.bits_wave_y0s     = arena_push_array(&result.arena, BITS_WAVE_CAPACITY, uint8_t);
 
-			if((step_count++ >= max_step_count) || (curr->x == target_x && curr->y == target_y))
-			{
-				push_path(&result, curr, arena);
-				break;
-			}
+	return result;
+}
 
-			int neighbor_offsets_x[] = {1, 0, -1,  0};
-			int neighbor_offsets_y[] = {0, 1,  0, -1};
+GridNodePool *grid_node_pool_get()
+{
+	thread_local GridNodePool pool = grid_node_pool_make();
+	return &pool;
+}
 
-			for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
-			{
-				int neighbor_x = curr->x + neighbor_offsets_x[neighbor_idx];
-				int neighbor_y = curr->y + neighbor_offsets_y[neighbor_idx];
+void grid_node_pool_begin_search(GridNodePool *pool)
+{
+	++pool->generation;
 
-				if(neighbor_x >= 0 && neighbor_x < MAP_W && neighbor_y >= 0 && neighbor_y < MAP_H && map[neighbor_y * MAP_W + neighbor_x] == 0)
-				{
-					GridNode *neighbor = &grid_node_map[neighbor_y * MAP_W + neighbor_x];
+	// Only on wrap around, stale stamps could otherwise match again
+	if(pool->generation == 0)
+	{
+		mem_zero_array(pool->nodes,         MAP_W * MAP_H);
+		mem_zero_array(pool->reverse_nodes, MAP_W * MAP_H);
+		mem_zero_array(pool->target_stamps, MAP_W * MAP_H);
+		pool->generation = 1;
+	}
+}
 
-					if(!neighbor->closed)
-					{
-						int g = curr->g + 1;
+GridNode *grid_node_get(GridNodePool *pool, GridNode *nodes, int x, int y)
+{
+	GridNode *result = &nodes[y * MAP_W + x];
+	if(result->generation != pool->generation)
+	{
+		result->generation = pool->generation;
+		result->x          = x;
+		result->y          = y;
+		result->g          = 0;
+		result->h          = 0;
+		result->opened     = false;
+		result->closed     = false;
+		result->parent     = NULL;
+	}
 
-						if(!neighbor->opened)
-						{
-							neighbor->x      = neighbor_x;
-							neighbor->y      = neighbor_y;
-							neighbor->g      = g;
-							neighbor->opened = true;
-							neighbor->parent = curr;
+	return result;
+}
 
-							grid_node_set_h(neighbor, target_x, target_y);
+GridNode *grid_node_get(GridNodePool *pool, int x, int y)
+{
+	GridNode *result = grid_node_get(pool, pool->nodes, x, y);
+	return result;
+}
 
-							heap_insert(&open_list, neighbor);
-						}else if(g < neighbor->g)
-						{
-							neighbor->g      = g;
-							neighbor->parent = curr;
+// Common open list interface so the A* loop can be instantiated for either queue.
+// Storage is one of the pool's slots and is expected to be empty.
+void queue_init(GridNodeHeap *heap, GridNodePool *pool, int slot)
+{
+	*heap       = {};
+	heap->nodes = pool->heap_nodes[slot];
+}
 
-							heap_heapify_up(&open_list, neighbor->heap_idx);
-						}
-					}
-				}
-			}
-		}
-	}
+void queue_init(GridNodeBuckets *buckets, GridNodePool *pool, int slot)
+{
+	*buckets            = {};
+	buckets->min_bucket = GRID_NODE_BUCKET_COUNT;
+	buckets->max_bucket = -1;
+	buckets->buckets    = pool->buckets[slot];
+}
 
-	arena_end_scratch(scratch);
-	
-	return result;
+// Empties the queue so its storage can be handed to the next search, returns the bytes cleared
+uint64_t queue_release(GridNodeHeap *heap)
+{
+	heap->node_count = 0;
+	return 0;
 }
 
-FoundPath path_find_target(MapTile *map, int start_x, int start_y, int target_x, int target_y, int max_step_count, Arena *arena)
+uint64_t queue_release(GridNodeBuckets *buckets)
 {
-	PathTile   target = {target_x, target_y};
-	FoundPaths paths  = path_find_targets(map, start_x, start_y, &target, 1, max_step_count, arena);
+	uint64_t result = 0;
+	if(buckets->min_bucket <= buckets->max_bucket)
+	{
+		int bucket_count = buckets->max_bucket - buckets->min_bucket + 1;
+		mem_zero_array(buckets->buckets + buckets->min_bucket, bucket_count);
 
-	assert(paths.count == 1);
+		result = bucket_count * sizeof(GridNode *);
+	}
+
+	buckets->node_count = 0;
+	buckets->min_bucket = GRID_NODE_BUCKET_COUNT;
+	buckets->max_bucket = -1;
 
-	FoundPath result = paths.paths[0];
 	return result;
 }
 
+int queue_count(GridNodeHeap *heap)
+{
+	return heap->node_count;
+}
+
+int queue_count(GridNodeBuckets *buckets)
+{
+	return buckets->node_count;
+}
+
+GridNode *queue_get_min(GridNodeHeap *heap)
+{
+	return heap->nodes[0];
+}
+
+GridNode *queue_get_min(GridNodeBuckets *buckets)
+{
+	return buckets_get_min(buckets);
+}
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL>
+void queue_remove_min(GridNodeHeap *heap)
+{
+	heap_remove_min<policy>(heap);
+}
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL>
+void queue_remove_min(GridNodeBuckets *buckets)
+{
+	buckets_remove(buckets, buckets_get_min(buckets));
+}
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL>
+void queue_insert(GridNodeHeap *heap, GridNode *node)
+{
+	heap_insert<policy>(heap, node);
+}
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL>
+void queue_insert(GridNodeBuckets *buckets, GridNode *node)
+{
+	buckets_insert<policy>(buckets, node);
+}
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL>
+void queue_decrease_key(GridNodeHeap *heap, GridNode *node)
+{
+	heap_heapify_up<policy>(heap, node->heap_idx);
+}
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL>
+void queue_decrease_key(GridNodeBuckets *buckets, GridNode *node)
+{
+	buckets_update<policy>(buckets, node);
+}
+
+// Moves every node of src into the empty dst with h recomputed for the new target
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL>
+void queue_retarget(GridNodeHeap *dst, GridNodeHeap *src, int target_x, int target_y, int weight = PATH_FIND_WEIGHT_ONE, LandmarkFields *landmarks = NULL)
+{
+	dst->node_count = 0;
+
+	for(int node_idx = 0; node_idx < src->node_count; ++node_idx)
+	{
+		GridNode *node = src->nodes[node_idx];
+		grid_node_set_h<policy>(node, target_x, target_y, weight, landmarks);
+
+		heap_insert<policy>(dst, node);
+	}
+
+	swap(*dst, *src);
+}
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL>
+void queue_retarget(GridNodeBuckets *dst, GridNodeBuckets *src, int target_x, int target_y, int weight = PATH_FIND_WEIGHT_ONE, LandmarkFields *landmarks = NULL)
+{
+	for(int bucket_idx = src->min_bucket; bucket_idx <= src->max_bucket; ++bucket_idx)
+	{
+		GridNode *node = src->buckets[bucket_idx];
+		while(node)
+		{
+			GridNode *next = node->bucket_next;
+			grid_node_set_h<policy>(node, target_x, target_y, weight, landmarks);
+
+			buckets_insert<policy>(dst, node);
+			node = next;
+		}
+
+		src->buckets[bucket_idx] = NULL;
+	}
+
+	src->node_count = 0;
+	src->min_bucket = GRID_NODE_BUCKET_COUNT;
+	src->max_bucket = -1;
+
+	swap(*dst, *src);
+}
+
+bool map_is_free(OccupancyMap *map, int x, int y)
+{
+	bool result = x >= 0 && x < MAP_W && y >= 0 && y < MAP_H && !occupancy_test(map, x, y);
+	return result;
+}
+
+// Parents are at most one straight segment away (a single tile for A*, a whole jump for JPS), the
+// gaps are filled in here so both produce the same per-tile paths
+void push_path(FoundPaths *paths, GridNode *node, Arena *arena)
+{
+	FoundPath *path = &paths->paths[paths->count++];
+
+	path->tile_count = node->g + 1;
+	path->tiles      = arena_push_array(arena, path->tile_count, PathTile);
+
+	int tile_idx = path->tile_count - 1;
+	int x        = node->x;
+	int y        = node->y;
+	for(GridNode *n = node; n; n = n->parent)
+	{
+		int end_x = n->parent ? n->parent->x : n->x;
+		int end_y = n->parent ? n->parent->y : n->y;
+
+		int step_x = end_x > x ? 1 : (end_x < x ? -1 : 0);
+		int step_y = end_y > y ? 1 : (end_y < y ? -1 : 0);
+
+		while(x != end_x || y != end_y)
+		{
+			PathTile *tile = &path->tiles[tile_idx--];
+			tile->x        = x;
+			tile->y        = y;
+
+			x += step_x;
+			y += step_y;
+		}
+
+		if(!n->parent)
+		{
+			PathTile *tile = &path->tiles[tile_idx--];
+			tile->x        = x;
+			tile->y        = y;
+		}
+	}
+
+	assert(tile_idx == -1);
+}
+
+void emit_path(FoundPaths *paths, int *tile_counts, int target_idx, GridNode *node, Arena *arena)
+{
+	if(paths)
+	{
+		push_path(paths, node, arena);
+	}
+
+	if(tile_counts)
+	{
+		// Path length including the start tile, the same as FoundPath::tile_count
+		tile_counts[target_idx] = node->g + 1;
+	}
+}
+
+template <PathFindPolicy policy, typename Queue>
+void relax_node(Queue *open_list, GridNodePool *pool, GridNode *curr, int x, int y, int target_x, int target_y, int weight, LandmarkFields *landmarks, bool store_parent)
+{
+	GridNode *node = grid_node_get(pool, x, y);
+
+	if(!node->closed)
+	{
+		int g = curr->g + abs(x - curr->x) + abs(y - curr->y);
+
+		if(!node->opened)
+		{
+			node->g      = g;
+			node->opened = true;
+
+			if(store_parent)
+			{
+				node->parent = curr;
+			}
+
+			grid_node_set_h<policy>(node, target_x, target_y, weight, landmarks);
+
+			queue_insert<policy>(open_list, node);
+		}else if(g < node->g)
+		{
+			node->g = g;
+
+			if(store_parent)
+			{
+				node->parent = curr;
+			}
+
+			queue_decrease_key<policy>(open_list, node);
+		}
+	}
+}
+
+// 4-connected jump point search: scans from (x, y) in direction (dx, dy) and returns the tile index of the
+// first jump point, or -1 when the scan runs into a wall. Horizontal scans stop beside the corner an
+// obstacle ends at, vertical scans additionally stop wherever a horizontal scan would find a jump point.
+// Every target is a jump point so one scan serves all targets of a multi-target search.
+int jump(OccupancyMap *map, GridNodePool *pool, int x, int y, int dx, int dy)
+{
+	int result = -1;
+
+	while(map_is_free(map, x, y))
+	{
+		int idx = y * MAP_W + x;
+		if(pool->target_stamps[idx] == pool->generation)
+		{
+			result = idx;
+			break;
+		}
+
+		if(dx != 0)
+		{
+			if((map_is_free(map, x, y - 1) && !map_is_free(map, x - dx, y - 1)) ||
+			   (map_is_free(map, x, y + 1) && !map_is_free(map, x - dx, y + 1)))
+			{
+				result = idx;
+				break;
+			}
+		}else
+		{
+			if((map_is_free(map, x - 1, y) && !map_is_free(map, x - 1, y - dy)) ||
+			   (map_is_free(map, x + 1, y) && !map_is_free(map, x + 1, y - dy)))
+			{
+				result = idx;
+				break;
+			}
+
+			if(jump(map, pool, x + 1, y, 1, 0) >= 0 || jump(map, pool, x - 1, y, -1, 0) >= 0)
+			{
+				result = idx;
+				break;
+			}
+		}
+
+		x += dx;
+		y += dy;
+	}
+
+	return result;
+}
+
+// Shared search loop for the tile-producing and distance-only entry points, either plain A* or
+// A* over jump points. When paths is NULL no tiles are written and only tile_counts is filled
+// (0 for targets that cannot be reached). weight is fixed point, see PATH_FIND_WEIGHT_SHIFT. landmarks may be NULL.
+template <typename Queue, bool use_jump_points, PathFindPolicy policy>
+void path_find_targets_internal(OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, FoundPaths *paths, int *tile_counts, int weight, LandmarkFields *landmarks, PathFindStats *stats, Arena *arena)
+{
+	uint64_t expanded_node_count = 0;
+
+	GridNodePool *pool = grid_node_pool_get();
+	grid_node_pool_begin_search(pool);
+
+	GridNode *start_node = grid_node_get(pool, start_x, start_y);
+	start_node->opened   = true;
+
+	Queue open_list;
+	Queue tmp_open_list;
+	queue_init(&open_list,     pool, 0);
+	queue_init(&tmp_open_list, pool, 1);
+
+	// Jump point successors are found from the parent direction so parents are always needed
+	bool store_parent = paths || use_jump_points;
+
+	if(use_jump_points)
+	{
+		for(int target_idx = 0; target_idx < target_count; ++target_idx)
+		{
+			PathTile *target = &targets[target_idx];
+			pool->target_stamps[target->y * MAP_W + target->x] = pool->generation;
+		}
+	}
+
+	for(int target_idx = 0; target_idx < target_count; ++target_idx)
+	{
+		PathTile *target = &targets[target_idx];
+		int target_x = target->x;
+		int target_y = target->y;
+
+		if(tile_counts)
+		{
+			tile_counts[target_idx] = 0;
+		}
+
+		if(target_idx == 0)
+		{
+			grid_node_set_h<policy>(start_node, target_x, target_y, weight, landmarks);
+			queue_insert<policy>(&open_list, start_node);
+		}else
+		{
+			GridNode *target_node = grid_node_get(pool, target_x, target_y);
+			if(target_node->closed)
+			{
+				emit_path(paths, tile_counts, target_idx, target_node, arena);
+				continue;
+			}else
+			{
+				queue_retarget<policy>(&tmp_open_list, &open_list, target_x, target_y, weight, landmarks);
+			}
+		}
+
+		int step_count = 0;
+		while(queue_count(&open_list) > 0)
+		{
+			GridNode *curr = queue_get_min(&open_list);
+
+			// The target stays on the open list so that it is still expanded if a later target's path runs through it,
+			// closing it here without visiting its neighbors would make later distances non-optimal
+			if((step_count++ >= max_step_count) || (curr->x == target_x && curr->y == target_y))
+			{
+				emit_path(paths, tile_counts, target_idx, curr, arena);
+				break;
+			}
+
+			queue_remove_min<policy>(&open_list);
+			curr->closed = true;
+
+			++expanded_node_count;
+
+			int neighbor_offsets_x[] = {1, 0, -1,  0};
+			int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+			if(use_jump_points)
+			{
+				int dx = 0;
+				int dy = 0;
+				if(curr->parent)
+				{
+					dx = curr->x > curr->parent->x ? 1 : (curr->x < curr->parent->x ? -1 : 0);
+					dy = curr->y > curr->parent->y ? 1 : (curr->y < curr->parent->y ? -1 : 0);
+				}
+
+				for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
+				{
+					int offset_x = neighbor_offsets_x[neighbor_idx];
+					int offset_y = neighbor_offsets_y[neighbor_idx];
+
+					// Pruned neighbors: never straight back, and a horizontal arrival only continues horizontally
+					// or turns, which covers the same directions as a vertical arrival
+					bool is_backwards = (dx != 0 && offset_x == -dx) || (dy != 0 && offset_y == -dy);
+					if(!is_backwards)
+					{
+						int jump_point_idx = jump(map, pool, curr->x + offset_x, curr->y + offset_y, offset_x, offset_y);
+						if(jump_point_idx >= 0)
+						{
+							relax_node<policy>(&open_list, pool, curr, jump_point_idx % MAP_W, jump_point_idx / MAP_W, target_x, target_y, weight, landmarks, store_parent);
+						}
+					}
+				}
+			}else
+			{
+				for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
+				{
+					int neighbor_x = curr->x + neighbor_offsets_x[neighbor_idx];
+					int neighbor_y = curr->y + neighbor_offsets_y[neighbor_idx];
+
+					if(map_is_free(map, neighbor_x, neighbor_y))
+					{
+						relax_node<policy>(&open_list, pool, curr, neighbor_x, neighbor_y, target_x, target_y, weight, landmarks, store_parent);
+					}
+				}
+			}
+		}
+	}
+
+	// tmp_open_list is always left empty by queue_retarget
+	uint64_t cleared_byte_count = queue_release(&open_list);
+
+	if(stats)
+	{
+		++stats->search_count;
+		stats->expanded_node_count += expanded_node_count;
+		stats->cleared_byte_count  += cleared_byte_count;
+	}
+}
+
+// Single-target A* growing one tree from each end. Each step expands whichever side has the better open node and
+// mu is the cheapest start to target path seen where the trees touch. With consistent heuristics the smallest f
+// on either open list bounds every path not yet seen, so the search stops once either side's minimum f reaches mu.
+template <typename Queue>
+void path_find_bidirectional_internal(OccupancyMap *map, int start_x, int start_y, int target_x, int target_y, int max_step_count, FoundPaths *paths, int *tile_count, PathFindStats *stats, Arena *arena)
+{
+	uint64_t expanded_node_count = 0;
+
+	GridNodePool *pool = grid_node_pool_get();
+	grid_node_pool_begin_search(pool);
+
+	GridNode *nodes[2]  = {pool->nodes, pool->reverse_nodes};
+	int       goals_x[2] = {target_x, start_x};
+	int       goals_y[2] = {target_y, start_y};
+
+	Queue open_lists[2];
+	for(int side = 0; side < 2; ++side)
+	{
+		queue_init(&open_lists[side], pool, side);
+
+		GridNode *root = grid_node_get(pool, nodes[side], goals_x[side ^ 1], goals_y[side ^ 1]);
+		root->opened   = true;
+
+		grid_node_set_h(root, goals_x[side], goals_y[side]);
+		queue_insert(&open_lists[side], root);
+	}
+
+	// Where the cheapest path found so far crosses from the forward tree into the reverse tree, either the same
+	// tile or two neighbors
+	int       mu               = INT_MAX;
+	GridNode *meeting_nodes[2] = {};
+	if(start_x == target_x && start_y == target_y)
+	{
+		mu               = 0;
+		meeting_nodes[0] = grid_node_get(pool, nodes[0], start_x, start_y);
+		meeting_nodes[1] = grid_node_get(pool, nodes[1], start_x, start_y);
+	}
+
+	bool is_capped  = false;
+	int  step_count = 0;
+	while(queue_count(&open_lists[0]) > 0 && queue_count(&open_lists[1]) > 0)
+	{
+		GridNode *forward_min = queue_get_min(&open_lists[0]);
+		GridNode *reverse_min = queue_get_min(&open_lists[1]);
+		if(forward_min->g + forward_min->h >= mu || reverse_min->g + reverse_min->h >= mu)
+		{
+			break;
+		}
+
+		if(step_count++ >= max_step_count)
+		{
+			is_capped = true;
+			break;
+		}
+
+		int       side = grid_node_cmp(forward_min, reverse_min) <= 0 ? 0 : 1;
+		GridNode *curr = side == 0 ? forward_min : reverse_min;
+
+		queue_remove_min(&open_lists[side]);
+		curr->closed = true;
+
+		++expanded_node_count;
+
+		int neighbor_offsets_x[] = {1, 0, -1,  0};
+		int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+		for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
+		{
+			int neighbor_x = curr->x + neighbor_offsets_x[neighbor_idx];
+			int neighbor_y = curr->y + neighbor_offsets_y[neighbor_idx];
+
+			if(map_is_free(map, neighbor_x, neighbor_y))
+			{
+				GridNode *node = grid_node_get(pool, nodes[side], neighbor_x, neighbor_y);
+				if(node->closed)
+				{
+					continue;
+				}
+
+				// Read without grid_node_get, a stale stamp just means the other side has not been here
+				GridNode *other         = &nodes[side ^ 1][neighbor_y * MAP_W + neighbor_x];
+				bool      is_other_seen = other->generation == pool->generation && other->opened;
+
+				int g = curr->g + 1;
+				if(is_other_seen && g + other->g < mu)
+				{
+					mu                      = g + other->g;
+					meeting_nodes[side]     = curr;
+					meeting_nodes[side ^ 1] = other;
+				}
+
+				if(!node->opened)
+				{
+					// The other side already knows the best way on from a tile it closed, mu covers the path through it
+					if(is_other_seen && other->closed)
+					{
+						continue;
+					}
+
+					node->g      = g;
+					node->opened = true;
+					node->parent = curr;
+
+					grid_node_set_h(node, goals_x[side], goals_y[side]);
+					queue_insert(&open_lists[side], node);
+				}else if(g < node->g)
+				{
+					node->g      = g;
+					node->parent = curr;
+
+					queue_decrease_key(&open_lists[side], node);
+				}
+			}
+		}
+	}
+
+	FoundPath path = {};
+	if(mu != INT_MAX)
+	{
+		path.tile_count = mu + 1;
+		if(paths)
+		{
+			// The forward tree fills tiles from the start, the reverse tree from the target, index mu - g counts back from it
+			path.tiles = arena_push_array(arena, path.tile_count, PathTile);
+			for(GridNode *node = meeting_nodes[0]; node; node = node->parent)
+			{
+				path.tiles[node->g] = {node->x, node->y};
+			}
+			for(GridNode *node = meeting_nodes[1]; node; node = node->parent)
+			{
+				path.tiles[mu - node->g] = {node->x, node->y};
+			}
+		}
+	}else if(is_capped)
+	{
+		// Same as the unidirectional search, the path towards the best forward node
+		GridNode *node = queue_get_min(&open_lists[0]);
+
+		path.tile_count = node->g + 1;
+		if(paths)
+		{
+			path.tiles = arena_push_array(arena, path.tile_count, PathTile);
+			for(; node; node = node->parent)
+			{
+				path.tiles[node->g] = {node->x, node->y};
+			}
+		}
+	}
+
+	if(paths)
+	{
+		paths->paths[paths->count++] = path;
+	}
+	if(tile_count)
+	{
+		*tile_count = path.tile_count;
+	}
+
+	uint64_t cleared_byte_count = queue_release(&open_lists[0]) + queue_release(&open_lists[1]);
+
+	if(stats)
+	{
+		++stats->search_count;
+		stats->expanded_node_count += expanded_node_count;
+		stats->cleared_byte_count  += cleared_byte_count;
+	}
+}
+
+bool path_footprint_test_rect(PathFootprint *footprint, int x0, int y0, int x1, int y1)
+{
+	bool result = false;
+	for(int box_idx = 0; box_idx < footprint->box_count && !result; ++box_idx)
+	{
+		result = footprint->x0[box_idx] < x1 && x0 < footprint->x1[box_idx] && footprint->y0[box_idx] < y1 && y0 < footprint->y1[box_idx];
+	}
+
+	return result;
+}
+
+// Search layers a footprint is traced through, a tile is in wave w if the search reached it with w + 1 tiles
+struct FloodWaves
+{
+	uint16_t *tile_distances;
+};
+
+struct BitsWaves
+{
+	uint64_t *rows;
+	int      *offsets;
+	uint8_t  *y0s;
+};
+
+bool path_waves_test(FloodWaves *waves, int x, int y, int wave_idx)
+{
+	bool result = waves->tile_distances[y * MAP_W + x] == wave_idx + 1;
+	return result;
+}
+
+bool path_waves_test(BitsWaves *waves, int x, int y, int wave_idx)
+{
+	int row_idx = y - waves->y0s[wave_idx];
+
+	bool result = false;
+	if(row_idx >= 0 && waves->offsets[wave_idx] + row_idx < waves->offsets[wave_idx + 1])
+	{
+		uint64_t *row = &waves->rows[(waves->offsets[wave_idx] + row_idx) * MAP_ROW_WORD_COUNT];
+		result        = (row[x / 64] >> (x % 64)) & 1;
+	}
+
+	return result;
+}
+
+// Walks back from a target reached with tile_count tiles, each step to a neighbor one wave closer to the start. Going
+// straight on while it can keeps the stretches, and so their boxes, narrow.
+template <typename Waves>
+void path_footprint_trace(Waves *waves, int x, int y, int tile_count, PathFootprint *footprint)
+{
+	int neighbor_offsets_x[] = {1, 0, -1,  0};
+	int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+	int stretch_tile_count = (tile_count + PATH_FOOTPRINT_BOX_COUNT - 1) / PATH_FOOTPRINT_BOX_COUNT;
+	int dir                = 0;
+
+	*footprint = {};
+	for(int tile_idx = 0; tile_idx < tile_count; ++tile_idx)
+	{
+		int box_idx = tile_idx / stretch_tile_count;
+		if(box_idx == footprint->box_count)
+		{
+			footprint->x0[box_idx] = (uint8_t)x;
+			footprint->y0[box_idx] = (uint8_t)y;
+			footprint->x1[box_idx] = (uint8_t)(x + 1);
+			footprint->y1[box_idx] = (uint8_t)(y + 1);
+			++footprint->box_count;
+		}else
+		{
+			footprint->x0[box_idx] = (uint8_t)min(footprint->x0[box_idx], x);
+			footprint->y0[box_idx] = (uint8_t)min(footprint->y0[box_idx], y);
+			footprint->x1[box_idx] = (uint8_t)max(footprint->x1[box_idx], x + 1);
+			footprint->y1[box_idx] = (uint8_t)max(footprint->y1[box_idx], y + 1);
+		}
+
+		int wave_idx = tile_count - tile_idx - 2;
+		for(int turn_idx = 0; turn_idx < 4 && wave_idx >= 0; ++turn_idx)
+		{
+			int neighbor_dir = (dir + turn_idx) % 4;
+			int neighbor_x   = x + neighbor_offsets_x[neighbor_dir];
+			int neighbor_y   = y + neighbor_offsets_y[neighbor_dir];
+
+			if(neighbor_x >= 0 && neighbor_x < MAP_W && neighbor_y >= 0 && neighbor_y < MAP_H && path_waves_test(waves, neighbor_x, neighbor_y, wave_idx))
+			{
+				x   = neighbor_x;
+				y   = neighbor_y;
+				dir = neighbor_dir;
+				break;
+			}
+		}
+	}
+}
+
+// Plain breadth first flood from the start tile. Every move costs 1 so the first time a
+// tile is dequeued its distance is final, and a single sweep labels all targets.
+void path_find_flood_internal(OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, int *tile_counts, PathFindStats *stats, PathFootprint *footprints)
+{
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	// Distances are stored +1 so that a zeroed array reads as unvisited
+	uint16_t *tile_distances = arena_push_array(scratch.arena, MAP_W * MAP_H, uint16_t);
+	uint8_t  *target_marks   = arena_push_array(scratch.arena, MAP_W * MAP_H, uint8_t);
+	uint16_t *queue          = arena_push_array(scratch.arena, MAP_W * MAP_H, uint16_t);
+
+	int remaining_target_count = 0;
+	for(int target_idx = 0; target_idx < target_count; ++target_idx)
+	{
+		PathTile *target = &targets[target_idx];
+		++target_marks[target->y * MAP_W + target->x];
+		++remaining_target_count;
+	}
+
+	int queue_front = 0;
+	int queue_back  = 0;
+
+	int start_idx = start_y * MAP_W + start_x;
+	tile_distances[start_idx] = 1;
+	queue[queue_back++]       = start_idx;
+
+	uint64_t expanded_node_count = 0;
+	while(queue_front < queue_back && remaining_target_count > 0)
+	{
+		int curr_idx      = queue[queue_front++];
+		int curr_distance = tile_distances[curr_idx];
+
+		remaining_target_count -= target_marks[curr_idx];
+		++expanded_node_count;
+
+		if(curr_distance > max_step_count)
+		{
+			continue;
+		}
+
+		int curr_x = curr_idx % MAP_W;
+		int curr_y = curr_idx / MAP_W;
+
+		int neighbor_offsets_x[] = {1, 0, -1,  0};
+		int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+		for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
+		{
+			int neighbor_x = curr_x + neighbor_offsets_x[neighbor_idx];
+			int neighbor_y = curr_y + neighbor_offsets_y[neighbor_idx];
+
+			if(neighbor_x >= 0 && neighbor_x < MAP_W && neighbor_y >= 0 && neighbor_y < MAP_H)
+			{
+				int neighbor_tile_idx = neighbor_y * MAP_W + neighbor_x;
+				if(!occupancy_test(map, neighbor_x, neighbor_y) && tile_distances[neighbor_tile_idx] == 0)
+				{
+					tile_distances[neighbor_tile_idx] = curr_distance + 1;
+					queue[queue_back++]               = neighbor_tile_idx;
+				}
+			}
+		}
+	}
+
+	for(int target_idx = 0; target_idx < target_count; ++target_idx)
+	{
+		PathTile *target = &targets[target_idx];
+		tile_counts[target_idx] = tile_distances[target->y * MAP_W + target->x];
+	}
+
+	if(footprints)
+	{
+		FloodWaves waves = {tile_distances};
+		for(int target_idx = 0; target_idx < target_count; ++target_idx)
+		{
+			if(tile_counts[target_idx] > 0)
+			{
+				path_footprint_trace(&waves, targets[target_idx].x, targets[target_idx].y, tile_counts[target_idx], &footprints[target_idx]);
+			}else
+			{
+				footprints[target_idx] = {};
+			}
+		}
+	}
+
+	if(stats)
+	{
+		++stats->search_count;
+		stats->expanded_node_count += expanded_node_count;
+		stats->cleared_byte_count  += MAP_W * MAP_H * (sizeof(*tile_distances) + sizeof(*target_marks) + sizeof(*queue));
+	}
+
+	arena_end_scratch(scratch);
+}
+
+uint64_t compact_heap_entry(int g, int h, int tile_idx)
+{
+	uint64_t result = ((uint64_t)(g + h) << 40) | ((uint64_t)h << 16) | (uint64_t)tile_idx;
+	return result;
+}
+
+void compact_heap_set(CompactHeap *heap, int slot, uint64_t entry)
+{
+	heap->entries[slot]          = entry;
+	heap->slots[entry & 0xFFFF] = (uint16_t)slot;
+}
+
+// Moves a hole instead of swapping, each step is one entry copy and one slot write
+void compact_heap_sift_up(CompactHeap *heap, int slot)
+{
+	uint64_t entry = heap->entries[slot];
+	while(slot > 0)
+	{
+		int parent_slot = get_parent_idx(slot);
+		if(heap->entries[parent_slot] <= entry)
+		{
+			break;
+		}
+
+		compact_heap_set(heap, slot, heap->entries[parent_slot]);
+		slot = parent_slot;
+	}
+
+	compact_heap_set(heap, slot, entry);
+}
+
+void compact_heap_sift_down(CompactHeap *heap, int slot)
+{
+	uint64_t entry = heap->entries[slot];
+	for(;;)
+	{
+		int child_slot = get_l_child_idx(slot);
+		if(child_slot >= heap->count)
+		{
+			break;
+		}
+
+		if(child_slot + 1 < heap->count && heap->entries[child_slot + 1] < heap->entries[child_slot])
+		{
+			++child_slot;
+		}
+
+		if(entry <= heap->entries[child_slot])
+		{
+			break;
+		}
+
+		compact_heap_set(heap, slot, heap->entries[child_slot]);
+		slot = child_slot;
+	}
+
+	compact_heap_set(heap, slot, entry);
+}
+
+void compact_push_path(FoundPaths *paths, GridNodePool *pool, int tile_idx, Arena *arena)
+{
+	int neighbor_offsets_x[] = {1, 0, -1,  0};
+	int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+	FoundPath *path = &paths->paths[paths->count++];
+
+	path->tile_count = pool->compact_g[tile_idx] + 1;
+	path->tiles      = arena_push_array(arena, path->tile_count, PathTile);
+
+	int x = tile_idx % MAP_W;
+	int y = tile_idx / MAP_W;
+	for(int path_tile_idx = path->tile_count - 1; path_tile_idx >= 0; --path_tile_idx)
+	{
+		PathTile *tile = &path->tiles[path_tile_idx];
+		tile->x        = x;
+		tile->y        = y;
+
+		// The direction is the move that reached this tile, step back against it
+		int dir = (pool->compact_states[y * MAP_W + x] >> COMPACT_STATE_DIR_SHIFT) & 3;
+		x -= neighbor_offsets_x[dir];
+		y -= neighbor_offsets_y[dir];
+	}
+}
+
+// A* with the same expansion order rules as path_find_targets_internal<GridNodeHeap, false>, but node state is
+// kept in parallel compact arrays and heap entries carry their own sort key, so sifting never dereferences nodes.
+void path_find_compact_internal(OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, FoundPaths *paths, int *tile_counts, PathFindStats *stats, Arena *arena)
+{
+	uint64_t expanded_node_count = 0;
+	uint64_t cleared_byte_count  = 0;
+
+	GridNodePool *pool = grid_node_pool_get();
+
+	// 4-bit stamps run out quickly, on wrap around the state bytes are cleared (16KB every 15 searches)
+	++pool->compact_generation;
+	if(pool->compact_generation > COMPACT_STATE_GENERATION_COUNT)
+	{
+		mem_zero_array(pool->compact_states, MAP_W * MAP_H);
+		cleared_byte_count += MAP_W * MAP_H * sizeof(*pool->compact_states);
+
+		pool->compact_generation = 1;
+	}
+
+	uint8_t   generation_bits = pool->compact_generation << COMPACT_STATE_GENERATION_SHIFT;
+	uint8_t  *states          = pool->compact_states;
+	uint16_t *g_values        = pool->compact_g;
+
+	CompactHeap open_list = {};
+	open_list.entries     = pool->compact_heap;
+	open_list.slots       = pool->compact_heap_slots;
+
+	int start_idx = start_y * MAP_W + start_x;
+	states[start_idx]   = generation_bits | COMPACT_STATE_OPENED;
+	g_values[start_idx] = 0;
+
+	for(int target_idx = 0; target_idx < target_count; ++target_idx)
+	{
+		PathTile *target = &targets[target_idx];
+		int target_x   = target->x;
+		int target_y   = target->y;
+		int target_idx_tile = target_y * MAP_W + target_x;
+
+		if(tile_counts)
+		{
+			tile_counts[target_idx] = 0;
+		}
+
+		if(target_idx == 0)
+		{
+			int h = abs(target_x - start_x) + abs(target_y - start_y);
+
+			open_list.count = 1;
+			compact_heap_set(&open_list, 0, compact_heap_entry(0, h, start_idx));
+		}else
+		{
+			uint8_t target_state = states[target_idx_tile];
+			if((target_state & 0xF0) == generation_bits && (target_state & COMPACT_STATE_CLOSED))
+			{
+				if(paths)
+				{
+					compact_push_path(paths, pool, target_idx_tile, arena);
+				}
+				if(tile_counts)
+				{
+					tile_counts[target_idx] = g_values[target_idx_tile] + 1;
+				}
+				continue;
+			}
+
+			// Rekey every open entry for the new target and rebuild the heap bottom up in O(n)
+			for(int slot = 0; slot < open_list.count; ++slot)
+			{
+				int tile_idx = (int)(open_list.entries[slot] & 0xFFFF);
+				int h        = abs(target_x - tile_idx % MAP_W) + abs(target_y - tile_idx / MAP_W);
+
+				open_list.entries[slot] = compact_heap_entry(g_values[tile_idx], h, tile_idx);
+			}
+
+			for(int slot = open_list.count / 2 - 1; slot >= 0; --slot)
+			{
+				compact_heap_sift_down(&open_list, slot);
+			}
+
+			for(int slot = 0; slot < open_list.count; ++slot)
+			{
+				open_list.slots[open_list.entries[slot] & 0xFFFF] = (uint16_t)slot;
+			}
+		}
+
+		int step_count = 0;
+		while(open_list.count > 0)
+		{
+			int curr_idx = (int)(open_list.entries[0] & 0xFFFF);
+
+			// Same as path_find_targets_internal, the target stays open for later targets
+			if((step_count++ >= max_step_count) || curr_idx == target_idx_tile)
+			{
+				if(paths)
+				{
+					compact_push_path(paths, pool, curr_idx, arena);
+				}
+				if(tile_counts)
+				{
+					tile_counts[target_idx] = g_values[curr_idx] + 1;
+				}
+				break;
+			}
+
+			if(--open_list.count > 0)
+			{
+				compact_heap_set(&open_list, 0, open_list.entries[open_list.count]);
+				compact_heap_sift_down(&open_list, 0);
+			}
+
+			states[curr_idx] |= COMPACT_STATE_CLOSED;
+			++expanded_node_count;
+
+			int curr_x = curr_idx % MAP_W;
+			int curr_y = curr_idx / MAP_W;
+			int g      = g_values[curr_idx] + 1;
+
+			int neighbor_offsets_x[] = {1, 0, -1,  0};
+			int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+			for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
+			{
+				int neighbor_x = curr_x + neighbor_offsets_x[neighbor_idx];
+				int neighbor_y = curr_y + neighbor_offsets_y[neighbor_idx];
+
+				if(map_is_free(map, neighbor_x, neighbor_y))
+				{
+					int neighbor_tile_idx = neighbor_y * MAP_W + neighbor_x;
+
+					uint8_t state = states[neighbor_tile_idx];
+					if((state & 0xF0) != generation_bits)
+					{
+						state = generation_bits;
+					}
+
+					if(!(state & COMPACT_STATE_CLOSED))
+					{
+						uint8_t new_state = generation_bits | COMPACT_STATE_OPENED | (neighbor_idx << COMPACT_STATE_DIR_SHIFT);
+						int     h         = abs(target_x - neighbor_x) + abs(target_y - neighbor_y);
+
+						if(!(state & COMPACT_STATE_OPENED))
+						{
+							states[neighbor_tile_idx]   = new_state;
+							g_values[neighbor_tile_idx] = g;
+
+							int slot = open_list.count++;
+							compact_heap_set(&open_list, slot, compact_heap_entry(g, h, neighbor_tile_idx));
+							compact_heap_sift_up(&open_list, slot);
+						}else if(g < g_values[neighbor_tile_idx])
+						{
+							states[neighbor_tile_idx]   = new_state;
+							g_values[neighbor_tile_idx] = g;
+
+							int slot = open_list.slots[neighbor_tile_idx];
+							compact_heap_set(&open_list, slot, compact_heap_entry(g, h, neighbor_tile_idx));
+							compact_heap_sift_up(&open_list, slot);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if(stats)
+	{
+		++stats->search_count;
+		stats->expanded_node_count += expanded_node_count;
+		stats->cleared_byte_count  += cleared_byte_count;
+	}
+}
+
+// Breadth first search where the frontier, the visited set and the free tiles are all bitsets. One wave
+// spreads every frontier row left, right, up and down with shifts and ORs, then masks with free & ~visited.
+// Only the band of rows the frontier can have reached is touched. Targets are read out of each new frontier
+// without branches, a target's bit is set in exactly one wave. With footprints every wave's band is kept in the pool
+// to trace the paths back through.
+void path_find_bits_internal(MapBits *free_bits, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, int *tile_counts, PathFindStats *stats, PathFootprint *footprints)
+{
+	MapBits visited  = {};
+	MapBits frontier = {};
+	MapBits next;
+
+	visited.rows[start_y][start_x / 64]  |= 1ull << (start_x % 64);
+	frontier.rows[start_y][start_x / 64] |= 1ull << (start_x % 64);
+
+	GridNodePool *pool = footprints ? grid_node_pool_get() : NULL;
+
+	BitsWaves waves      = {};
+	int       wave_count = 0;
+	if(pool)
+	{
+		waves.rows    = pool->bits_wave_rows;
+		waves.offsets = pool->bits_wave_offsets;
+		waves.y0s     = pool->bits_wave_y0s;
+
+		memcpy(waves.rows, frontier.rows[start_y], sizeof(frontier.rows[start_y]));
+		waves.offsets[0] = 0;
+		waves.offsets[1] = 1;
+		waves.y0s[0]     = (uint8_t)start_y;
+		wave_count       = 1;
+	}
+
+	int remaining_target_count = target_count;
+	for(int target_idx = 0; target_idx < target_count; ++target_idx)
+	{
+		PathTile *target = &targets[target_idx];
+
+		uint64_t hit = map_bits_test(&frontier, target->x, target->y);
+
+		tile_counts[target_idx] = (int)hit;
+		remaining_target_count -= (int)hit;
+	}
+
+	uint64_t expanded_node_count = 1;
+
+	int band_y0 = start_y;
+	int band_y1 = start_y;
+
+	int tile_count = 1;
+	while(remaining_target_count > 0 && band_y0 <= band_y1 && tile_count <= max_step_count)
+	{
+		++tile_count;
+
+		int next_band_y0 = max(band_y0 - 1, 0);
+		int next_band_y1 = min(band_y1 + 1, MAP_H - 1);
+
+		int new_band_y0 = MAP_H;
+		int new_band_y1 = -1;
+
+		for(int y = next_band_y0; y <= next_band_y1; ++y)
+		{
+			uint64_t *row   = frontier.rows[y];
+			uint64_t *above = y > 0         ? frontier.rows[y - 1] : NULL;
+			uint64_t *below = y < MAP_H - 1 ? frontier.rows[y + 1] : NULL;
+
+			uint64_t row_bits = 0;
+			for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+			{
+				uint64_t word = row[word_idx];
+
+				// Bits carried across word boundaries when shifting towards higher and lower x
+				uint64_t carry_up   = word_idx > 0                      ? row[word_idx - 1] >> 63 : 0;
+				uint64_t carry_down = word_idx < MAP_ROW_WORD_COUNT - 1 ? row[word_idx + 1] << 63 : 0;
+
+				uint64_t spread = (word << 1) | carry_up | (word >> 1) | carry_down;
+				if(above)
+				{
+					spread |= above[word_idx];
+				}
+				if(below)
+				{
+					spread |= below[word_idx];
+				}
+
+				uint64_t new_bits = spread & free_bits->rows[y][word_idx] & ~visited.rows[y][word_idx];
+
+				next.rows[y][word_idx] = new_bits;
+				row_bits              |= new_bits;
+
+				expanded_node_count += __popcnt64(new_bits);
+			}
+
+			if(row_bits)
+			{
+				new_band_y0 = min(new_band_y0, y);
+				new_band_y1 = max(new_band_y1, y);
+			}
+		}
+
+		// The next band covers the old one, so copying it over also clears every stale frontier row
+		for(int y = next_band_y0; y <= next_band_y1; ++y)
+		{
+			for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+			{
+				frontier.rows[y][word_idx]  = next.rows[y][word_idx];
+				visited.rows[y][word_idx]  |= next.rows[y][word_idx];
+			}
+		}
+
+		// Waves past the capacity are not kept, their targets get no footprint
+		if(pool && wave_count < BITS_WAVE_CAPACITY)
+		{
+			int offset = waves.offsets[wave_count];
+			memcpy(&waves.rows[offset * MAP_ROW_WORD_COUNT], frontier.rows[next_band_y0], (next_band_y1 - next_band_y0 + 1) * sizeof(frontier.rows[0]));
+
+			waves.offsets[wave_count + 1] = offset + next_band_y1 - next_band_y0 + 1;
+			waves.y0s[wave_count]         = (uint8_t)next_band_y0;
+			++wave_count;
+		}
+
+		for(int target_idx = 0; target_idx < target_count; ++target_idx)
+		{
+			PathTile *target = &targets[target_idx];
+
+			uint64_t hit = map_bits_test(&frontier, target->x, target->y);
+
+			tile_counts[target_idx] += (int)hit * tile_count;
+			remaining_target_count  -= (int)hit;
+		}
+
+		band_y0 = new_band_y0;
+		band_y1 = new_band_y1;
+	}
+
+	if(footprints)
+	{
+		for(int target_idx = 0; target_idx < target_count; ++target_idx)
+		{
+			if(tile_counts[target_idx] > 0 && tile_counts[target_idx] <= wave_count)
+			{
+				path_footprint_trace(&waves, targets[target_idx].x, targets[target_idx].y, tile_counts[target_idx], &footprints[target_idx]);
+			}else
+			{
+				footprints[target_idx] = {};
+			}
+		}
+	}
+
+	if(stats)
+	{
+		++stats->search_count;
+		stats->expanded_node_count += expanded_node_count;
+		stats->cleared_byte_count  += sizeof(visited) + sizeof(frontier);
+	}
+}
+
+// Multi-source BFS. Every tile holds a word with bit k set once door k's search has reached it, so one
+// sweep advances all door searches together and each wave only visits the tiles some search reached last
+// wave. The distance matrix is read out of the door tiles as their bits arrive.
+void path_find_multi_source_internal(OccupancyMap *map, PathTile *doors, int door_count, int max_step_count, int *distances, PathFindStats *stats)
+{
+	assert(door_count <= MAX_MULTI_SOURCE_COUNT);
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	uint64_t *seen        = arena_push_array(scratch.arena, MAP_W * MAP_H, uint64_t);
+	uint64_t *frontier    = arena_push_array(scratch.arena, MAP_W * MAP_H, uint64_t);
+	uint64_t *next        = arena_push_array(scratch.arena, MAP_W * MAP_H, uint64_t);
+	uint16_t *active      = arena_push_array(scratch.arena, MAP_W * MAP_H, uint16_t);
+	uint16_t *next_active = arena_push_array(scratch.arena, MAP_W * MAP_H, uint16_t);
+	int      *door_tiles  = arena_push_array(scratch.arena, door_count, int);
+
+	mem_zero_array(distances, door_count * door_count);
+
+	int active_count = 0;
+	for(int door_idx = 0; door_idx < door_count; ++door_idx)
+	{
+		PathTile *door = &doors[door_idx];
+
+		int tile_idx = door->y * MAP_W + door->x;
+		door_tiles[door_idx] = tile_idx;
+
+		if(!frontier[tile_idx])
+		{
+			active[active_count++] = tile_idx;
+		}
+
+		seen[tile_idx]     |= 1ull << door_idx;
+		frontier[tile_idx] |= 1ull << door_idx;
+	}
+
+	uint64_t all_doors_mask = door_count == 64 ? ~0ull : (1ull << door_count) - 1;
+
+	uint64_t expanded_node_count = 0;
+
+	int tile_count = 1;
+	for(;;)
+	{
+		// Record every search that arrived at a door this wave
+		bool is_done = true;
+		for(int door_idx = 0; door_idx < door_count; ++door_idx)
+		{
+			int tile_idx = door_tiles[door_idx];
+
+			uint64_t arrived = frontier[tile_idx];
+			while(arrived)
+			{
+				unsigned long source_idx;
+				_BitScanForward64(&source_idx, arrived);
+				arrived &= arrived - 1;
+
+				if(source_idx != (unsigned long)door_idx)
+				{
+					distances[source_idx * door_count + door_idx] = tile_count;
+				}
+			}
+
+			is_done = is_done && seen[tile_idx] == all_doors_mask;
+		}
+
+		if(is_done || active_count == 0 || tile_count > max_step_count)
+		{
+			break;
+		}
+
+		++tile_count;
+
+		int next_active_count = 0;
+		for(int active_idx = 0; active_idx < active_count; ++active_idx)
+		{
+			int tile_idx = active[active_idx];
+			int x        = tile_idx % MAP_W;
+			int y        = tile_idx / MAP_W;
+
+			uint64_t bits = frontier[tile_idx];
+			frontier[tile_idx] = 0;
+
+			int neighbor_offsets_x[] = {1, 0, -1,  0};
+			int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+			for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
+			{
+				int neighbor_x = x + neighbor_offsets_x[neighbor_idx];
+				int neighbor_y = y + neighbor_offsets_y[neighbor_idx];
+
+				if(map_is_free(map, neighbor_x, neighbor_y))
+				{
+					int neighbor_tile_idx = neighbor_y * MAP_W + neighbor_x;
+
+					// Marking seen right away is fine, anything else arriving this wave has the same distance
+					uint64_t new_bits = bits & ~seen[neighbor_tile_idx];
+					if(new_bits)
+					{
+						if(!next[neighbor_tile_idx])
+						{
+							next_active[next_active_count++] = neighbor_tile_idx;
+						}
+
+						next[neighbor_tile_idx] |= new_bits;
+						seen[neighbor_tile_idx] |= new_bits;
+					}
+				}
+			}
+		}
+
+		expanded_node_count += active_count;
+
+		// frontier is all zero again, so it becomes the next wave's scratch
+		swap(frontier, next);
+		swap(active,   next_active);
+		active_count = next_active_count;
+	}
+
+	if(stats)
+	{
+		++stats->search_count;
+		stats->expanded_node_count += expanded_node_count;
+		stats->cleared_byte_count  += MAP_W * MAP_H * (3 * sizeof(*seen) + 2 * sizeof(*active));
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// Lockstep rows hold word 0 of every lane, then word 1 of every lane
+int lockstep_get_word_idx(int lane_count, int lane, int x, int y)
+{
+	int result = (y * MAP_ROW_WORD_COUNT + x / 64) * lane_count + lane;
+	return result;
+}
+
+// Adds tile_count to each target the lane's frontier reached this wave, returns how many it reached
+int lockstep_label_targets(uint64_t *frontier, int lane_count, int lane, PathTile *targets, int target_count, int tile_count, int *tile_counts)
+{
+	int result = 0;
+
+	for(int target_idx = 0; target_idx < target_count; ++target_idx)
+	{
+		PathTile *target = &targets[target_idx];
+
+		uint64_t word = frontier[lockstep_get_word_idx(lane_count, lane, target->x, target->y)];
+		int      hit  = (int)((word >> (target->x % 64)) & 1);
+
+		tile_counts[target_idx] += hit * tile_count;
+		result                  += hit;
+	}
+
+	return result;
+}
+
+// path_find_bits_internal with lane_count maps advancing together, lane i of a sweep floods from door door_idx of
+// map i towards its higher-indexed doors. Lanes past used_lane_count are all blocked and never spread.
+template <int lane_count>
+void path_find_lockstep_internal(OccupancyMap **maps, PathTile **doors, int *door_counts, int used_lane_count, int max_step_count, int **distances, PathFindStats *stats)
+{
+	const int row_stride = MAP_ROW_WORD_COUNT * lane_count;
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	uint64_t *free_words = arena_push_array(scratch.arena, MAP_H * row_stride, uint64_t);
+	uint64_t *visited    = arena_push_array(scratch.arena, MAP_H * row_stride, uint64_t);
+	uint64_t *frontier   = arena_push_array(scratch.arena, MAP_H * row_stride, uint64_t);
+	uint64_t *next       = arena_push_array(scratch.arena, MAP_H * row_stride, uint64_t);
+	uint64_t *empty_row  = arena_push_array(scratch.arena, row_stride, uint64_t); // Above the top and below the bottom row
+	MapBits  *lane_bits  = arena_push_array(scratch.arena, 1, MapBits);
+
+	int max_door_count = 0;
+	for(int lane = 0; lane < used_lane_count; ++lane)
+	{
+		map_bits_from_occupancy(lane_bits, maps[lane]);
+
+		for(int y = 0; y < MAP_H; ++y)
+		{
+			for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+			{
+				free_words[y * row_stride + word_idx * lane_count + lane] = lane_bits->rows[y][word_idx];
+			}
+		}
+
+		int door_count = door_counts[lane];
+		for(int door_idx = 0; door_idx < door_count; ++door_idx)
+		{
+			distances[lane][door_idx * door_count + door_idx] = 0;
+		}
+
+		max_door_count = max(max_door_count, door_count);
+	}
+
+	uint64_t search_count        = 0;
+	uint64_t expanded_node_count = 0;
+	uint64_t cleared_byte_count  = 0;
+
+	for(int door_idx = 0; door_idx + 1 < max_door_count; ++door_idx)
+	{
+		mem_zero_array(visited,  MAP_H * row_stride);
+		mem_zero_array(frontier, MAP_H * row_stride);
+		cleared_byte_count += 2 * MAP_H * row_stride * sizeof(uint64_t);
+
+		// A lane's new bits are masked off once it has labelled all of its targets, so it stops widening the band
+		uint64_t lane_masks[lane_count]              = {};
+		int      remaining_target_counts[lane_count] = {};
+		int      remaining_lane_count                = 0;
+
+		int band_y0 = MAP_H;
+		int band_y1 = -1;
+
+		for(int lane = 0; lane < used_lane_count; ++lane)
+		{
+			int target_count = door_counts[lane] - (door_idx + 1);
+			if(target_count > 0)
+			{
+				PathTile *start      = &doors[lane][door_idx];
+				int       word_idx   = lockstep_get_word_idx(lane_count, lane, start->x, start->y);
+				uint64_t  start_bit  = 1ull << (start->x % 64);
+
+				visited [word_idx] |= start_bit;
+				frontier[word_idx] |= start_bit;
+
+				int *tile_counts = &distances[lane][door_idx * door_counts[lane] + door_idx + 1];
+				mem_zero_array(tile_counts, target_count);
+
+				remaining_target_counts[lane] = target_count - lockstep_label_targets(frontier, lane_count, lane, start + 1, target_count, 1, tile_counts);
+				if(remaining_target_counts[lane] > 0)
+				{
+					lane_masks[lane] = ~0ull;
+					++remaining_lane_count;
+				}
+
+				band_y0 = min(band_y0, start->y);
+				band_y1 = max(band_y1, start->y);
+
+				++search_count;
+			}
+		}
+
+		int tile_count = 1;
+		while(remaining_lane_count > 0 && band_y0 <= band_y1 && tile_count <= max_step_count)
+		{
+			++tile_count;
+
+			int next_band_y0 = max(band_y0 - 1, 0);
+			int next_band_y1 = min(band_y1 + 1, MAP_H - 1);
+
+			int new_band_y0 = MAP_H;
+			int new_band_y1 = -1;
+
+			for(int y = next_band_y0; y <= next_band_y1; ++y)
+			{
+				// Rows of different arrays never overlap, without __restrict the lane loop is not vectorized
+				uint64_t *__restrict row         = &frontier[y * row_stride];
+				uint64_t *__restrict above       = y > 0         ? row - row_stride : empty_row;
+				uint64_t *__restrict below       = y < MAP_H - 1 ? row + row_stride : empty_row;
+				uint64_t *__restrict free_row    = &free_words[y * row_stride];
+				uint64_t *__restrict visited_row = &visited   [y * row_stride];
+				uint64_t *__restrict next_row    = &next      [y * row_stride];
+
+				uint64_t row_bits = 0;
+				for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+				{
+					for(int lane = 0; lane < lane_count; ++lane)
+					{
+						int idx = word_idx * lane_count + lane;
+
+						uint64_t word = row[idx];
+
+						// Bits carried across word boundaries, from the same lane of the neighboring word
+						uint64_t carry_up   = word_idx > 0                      ? row[idx - lane_count] >> 63 : 0;
+						uint64_t carry_down = word_idx < MAP_ROW_WORD_COUNT - 1 ? row[idx + lane_count] << 63 : 0;
+
+						uint64_t spread   = (word << 1) | carry_up | (word >> 1) | carry_down | above[idx] | below[idx];
+						uint64_t new_bits = spread & free_row[idx] & ~visited_row[idx] & lane_masks[lane];
+
+						// Only this word reads its visited bits, so they can be updated in place
+						next_row[idx]     = new_bits;
+						visited_row[idx] |= new_bits;
+						row_bits         |= new_bits;
+					}
+				}
+
+				if(row_bits)
+				{
+					new_band_y0 = min(new_band_y0, y);
+					new_band_y1 = max(new_band_y1, y);
+				}
+			}
+
+			// The next band covers the old one, so copying it over also clears every stale frontier row
+			int band_offset     = next_band_y0 * row_stride;
+			int band_word_count = (next_band_y1 - next_band_y0 + 1) * row_stride;
+			mem_copy_array(frontier + band_offset, band_word_count, next + band_offset, band_word_count);
+
+			for(int lane = 0; lane < used_lane_count; ++lane)
+			{
+				if(lane_masks[lane])
+				{
+					PathTile *targets     = &doors[lane][door_idx + 1];
+					int       target_count = door_counts[lane] - (door_idx + 1);
+					int      *tile_counts = &distances[lane][door_idx * door_counts[lane] + door_idx + 1];
+
+					remaining_target_counts[lane] -= lockstep_label_targets(frontier, lane_count, lane, targets, target_count, tile_count, tile_counts);
+					if(remaining_target_counts[lane] == 0)
+					{
+						lane_masks[lane] = 0;
+						--remaining_lane_count;
+					}
+				}
+			}
+
+			band_y0 = new_band_y0;
+			band_y1 = new_band_y1;
+		}
+
+		// Every visited tile was expanded once, counted here rather than in the wave loop
+		for(int idx = 0; idx < MAP_H * row_stride; ++idx)
+		{
+			expanded_node_count += __popcnt64(visited[idx]);
+		}
+
+		// Mirror into the lower triangle like path_find_door_distances
+		for(int lane = 0; lane < used_lane_count; ++lane)
+		{
+			int door_count = door_counts[lane];
+			for(int target_idx = door_idx + 1; target_idx < door_count; ++target_idx)
+			{
+				distances[lane][target_idx * door_count + door_idx] = distances[lane][door_idx * door_count + target_idx];
+			}
+		}
+	}
+
+	if(stats)
+	{
+		stats->search_count        += search_count;
+		stats->expanded_node_count += expanded_node_count;
+		stats->cleared_byte_count  += cleared_byte_count;
+	}
+
+	arena_end_scratch(scratch);
+}
+
+void path_find_lockstep_door_distances(OccupancyMap **maps, PathTile **doors, int *door_counts, int lane_count, int max_step_count, int **distances, PathFindStats *stats)
+{
+	assert(lane_count > 0 && lane_count <= MAX_LOCKSTEP_LANE_COUNT);
+
+	// Narrower sweeps for short batches, the unused lanes of a width still cost their share of every wave
+	if(lane_count == 1)
+	{
+		path_find_lockstep_internal<1>(maps, doors, door_counts, lane_count, max_step_count, distances, stats);
+	}else if(lane_count == 2)
+	{
+		path_find_lockstep_internal<2>(maps, doors, door_counts, lane_count, max_step_count, distances, stats);
+	}else if(lane_count <= 4)
+	{
+		path_find_lockstep_internal<4>(maps, doors, door_counts, lane_count, max_step_count, distances, stats);
+	}else
+	{
+		path_find_lockstep_internal<MAX_LOCKSTEP_LANE_COUNT>(maps, doors, door_counts, lane_count, max_step_count, distances, stats);
+	}
+}
+
+void hpa_add_touched_clusters(HpaClusterSet *clusters, int x0, int y0, int x1, int y1)
+{
+	if(x0 < x1 && y0 < y1)
+	{
+		// Border tiles also decide the entrances of the cluster across the border, so the rectangle is grown by a tile
+		int cluster_x0 = max(x0 - 1, 0) / HPA_CLUSTER_SIZE;
+		int cluster_y0 = max(y0 - 1, 0) / HPA_CLUSTER_SIZE;
+		int cluster_x1 = min(x1, MAP_W - 1) / HPA_CLUSTER_SIZE;
+		int cluster_y1 = min(y1, MAP_H - 1) / HPA_CLUSTER_SIZE;
+
+		for(int cluster_y = cluster_y0; cluster_y <= cluster_y1; ++cluster_y)
+		{
+			for(int cluster_x = cluster_x0; cluster_x <= cluster_x1; ++cluster_x)
+			{
+				int cluster_idx = cluster_y * HPA_CLUSTER_COUNT_X + cluster_x;
+				clusters->words[cluster_idx / 64] |= 1ull << (cluster_idx % 64);
+			}
+		}
+	}
+}
+
+int hpa_get_cluster_idx(int x, int y)
+{
+	int result = (y / HPA_CLUSTER_SIZE) * HPA_CLUSTER_COUNT_X + x / HPA_CLUSTER_SIZE;
+	return result;
+}
+
+int hpa_get_local_idx(int x, int y)
+{
+	int result = (y % HPA_CLUSTER_SIZE) * HPA_CLUSTER_SIZE + x % HPA_CLUSTER_SIZE;
+	return result;
+}
+
+// Fills the offsets along the border where entrances sit and returns their count. Both clusters sharing a border
+// walk the same tile pairs in the same order, so they agree on the entrances without looking at each other.
+int hpa_get_border_entrances(OccupancyMap *map, int cluster_idx, int border, int *offsets)
+{
+	int inside_x = (cluster_idx % HPA_CLUSTER_COUNT_X) * HPA_CLUSTER_SIZE;
+	int inside_y = (cluster_idx / HPA_CLUSTER_COUNT_X) * HPA_CLUSTER_SIZE;
+
+	int along_x  = 0;
+	int along_y  = 0;
+	int across_x = 0;
+	int across_y = 0;
+	switch(border)
+	{
+		case HPA_BORDER_LEFT:
+			along_y  = 1;
+			across_x = -1;
+			break;
+
+		case HPA_BORDER_RIGHT:
+			inside_x += HPA_CLUSTER_SIZE - 1;
+			along_y   = 1;
+			across_x  = 1;
+			break;
+
+		case HPA_BORDER_TOP:
+			along_x  = 1;
+			across_y = -1;
+			break;
+
+		case HPA_BORDER_BOTTOM:
+			inside_y += HPA_CLUSTER_SIZE - 1;
+			along_x   = 1;
+			across_y  = 1;
+			break;
+	}
+
+	int result    = 0;
+	int run_start = -1;
+
+	// One past the end closes the last run
+	for(int offset = 0; offset <= HPA_CLUSTER_SIZE; ++offset)
+	{
+		bool is_open = false;
+		if(offset < HPA_CLUSTER_SIZE)
+		{
+			int x = inside_x + along_x * offset;
+			int y = inside_y + along_y * offset;
+
+			is_open = map_is_free(map, x, y) && map_is_free(map, x + across_x, y + across_y);
+		}
+
+		if(is_open && run_start < 0)
+		{
+			run_start = offset;
+		}else if(!is_open && run_start >= 0)
+		{
+			int run_end = offset - 1;
+			if(run_end - run_start + 1 >= HPA_LONG_ENTRANCE_RUN)
+			{
+				offsets[result++] = run_start;
+				offsets[result++] = run_end;
+			}else
+			{
+				offsets[result++] = (run_start + run_end) / 2;
+			}
+
+			run_start = -1;
+		}
+	}
+
+	assert(result <= HPA_MAX_BORDER_ENTRANCE_COUNT);
+
+	return result;
+}
+
+// Breadth first search that never leaves the cluster of the start tile. labels is indexed by hpa_get_local_idx and
+// holds steps + 1, node_costs receives the steps to each of the cluster's nodes. Returns the visited tile count.
+int hpa_cluster_flood(HpaGraph *graph, OccupancyMap *map, int start_x, int start_y, uint16_t *labels, uint16_t *node_costs)
+{
+	int cluster_x0 = (start_x / HPA_CLUSTER_SIZE) * HPA_CLUSTER_SIZE;
+	int cluster_y0 = (start_y / HPA_CLUSTER_SIZE) * HPA_CLUSTER_SIZE;
+
+	uint8_t queue[HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE];
+	static_assert(HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE <= 256);
+
+	mem_zero_array(labels, HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE);
+
+	int queue_front = 0;
+	int queue_back  = 0;
+
+	int start_idx = hpa_get_local_idx(start_x, start_y);
+	labels[start_idx]   = 1;
+	queue[queue_back++] = start_idx;
+
+	while(queue_front < queue_back)
+	{
+		int curr_idx   = queue[queue_front++];
+		int curr_label = labels[curr_idx];
+
+		int curr_x = curr_idx % HPA_CLUSTER_SIZE;
+		int curr_y = curr_idx / HPA_CLUSTER_SIZE;
+
+		int neighbor_offsets_x[] = {1, 0, -1,  0};
+		int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+		for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
+		{
+			int neighbor_x = curr_x + neighbor_offsets_x[neighbor_idx];
+			int neighbor_y = curr_y + neighbor_offsets_y[neighbor_idx];
+
+			if(neighbor_x >= 0 && neighbor_x < HPA_CLUSTER_SIZE && neighbor_y >= 0 && neighbor_y < HPA_CLUSTER_SIZE &&
+			   !occupancy_test(map, cluster_x0 + neighbor_x, cluster_y0 + neighbor_y))
+			{
+				int neighbor_tile_idx = neighbor_y * HPA_CLUSTER_SIZE + neighbor_x;
+				if(labels[neighbor_tile_idx] == 0)
+				{
+					labels[neighbor_tile_idx] = curr_label + 1;
+					queue[queue_back++]       = neighbor_tile_idx;
+				}
+			}
+		}
+	}
+
+	if(node_costs)
+	{
+		HpaCluster *cluster = &graph->clusters[hpa_get_cluster_idx(start_x, start_y)];
+		for(int node_idx = 0; node_idx < cluster->node_count; ++node_idx)
+		{
+			PathTile *node  = &cluster->nodes[node_idx];
+			int       label = labels[hpa_get_local_idx(node->x, node->y)];
+
+			node_costs[node_idx] = label ? label - 1 : HPA_UNREACHABLE;
+		}
+	}
+
+	return queue_back;
+}
+
+int hpa_cluster_build(HpaGraph *graph, OccupancyMap *map, int cluster_idx)
+{
+	HpaCluster *cluster = &graph->clusters[cluster_idx];
+	*cluster            = {};
+
+	int cluster_x0 = (cluster_idx % HPA_CLUSTER_COUNT_X) * HPA_CLUSTER_SIZE;
+	int cluster_y0 = (cluster_idx / HPA_CLUSTER_COUNT_X) * HPA_CLUSTER_SIZE;
+
+	for(int border = 0; border < HPA_BORDER_COUNT; ++border)
+	{
+		int offsets[HPA_MAX_BORDER_ENTRANCE_COUNT];
+		int entrance_count = hpa_get_border_entrances(map, cluster_idx, border, offsets);
+
+		cluster->border_node_starts[border] = cluster->node_count;
+		cluster->border_node_counts[border] = entrance_count;
+
+		for(int entrance_idx = 0; entrance_idx < entrance_count; ++entrance_idx)
+		{
+			int offset = offsets[entrance_idx];
+
+			PathTile *node = &cluster->nodes[cluster->node_count];
+			switch(border)
+			{
+				case HPA_BORDER_LEFT:   *node = {cluster_x0,                        cluster_y0 + offset}; break;
+				case HPA_BORDER_RIGHT:  *node = {cluster_x0 + HPA_CLUSTER_SIZE - 1, cluster_y0 + offset}; break;
+				case HPA_BORDER_TOP:    *node = {cluster_x0 + offset, cluster_y0                       }; break;
+				case HPA_BORDER_BOTTOM: *node = {cluster_x0 + offset, cluster_y0 + HPA_CLUSTER_SIZE - 1}; break;
+			}
+
+			cluster->node_borders[cluster->node_count++] = border;
+		}
+	}
+
+	int visited_tile_count = 0;
+	for(int node_idx = 0; node_idx < cluster->node_count; ++node_idx)
+	{
+		uint16_t labels[HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE];
+
+		PathTile *node = &cluster->nodes[node_idx];
+		visited_tile_count += hpa_cluster_flood(graph, map, node->x, node->y, labels, cluster->distances[node_idx]);
+	}
+
+	return visited_tile_count;
+}
+
+void hpa_graph_update(HpaGraph *graph, OccupancyMap *map, HpaClusterSet *dirty_clusters, PathFindStats *stats)
+{
+	uint64_t search_count        = 0;
+	uint64_t expanded_node_count = 0;
+	for(int cluster_idx = 0; cluster_idx < HPA_CLUSTER_COUNT; ++cluster_idx)
+	{
+		if(!dirty_clusters || ((dirty_clusters->words[cluster_idx / 64] >> (cluster_idx % 64)) & 1))
+		{
+			search_count        += graph->clusters[cluster_idx].node_count;
+			expanded_node_count += hpa_cluster_build(graph, map, cluster_idx);
+		}
+	}
+
+	if(stats)
+	{
+		stats->search_count        += search_count;
+		stats->expanded_node_count += expanded_node_count;
+	}
+}
+
+// Lazy deletion binary heap, entries are (cost << 32) | node
+struct HpaHeap
+{
+	int       count;
+	uint64_t *entries;
+};
+
+void hpa_heap_push(HpaHeap *heap, uint64_t entry)
+{
+	int slot = heap->count++;
+	while(slot > 0 && heap->entries[get_parent_idx(slot)] > entry)
+	{
+		heap->entries[slot] = heap->entries[get_parent_idx(slot)];
+		slot = get_parent_idx(slot);
+	}
+	heap->entries[slot] = entry;
+}
+
+uint64_t hpa_heap_pop(HpaHeap *heap)
+{
+	uint64_t result = heap->entries[0];
+	uint64_t entry  = heap->entries[--heap->count];
+
+	int slot = 0;
+	for(;;)
+	{
+		int child_slot = get_l_child_idx(slot);
+		if(child_slot >= heap->count)
+		{
+			break;
+		}
+
+		if(child_slot + 1 < heap->count && heap->entries[child_slot + 1] < heap->entries[child_slot])
+		{
+			++child_slot;
+		}
+
+		if(entry <= heap->entries[child_slot])
+		{
+			break;
+		}
+
+		heap->entries[slot] = heap->entries[child_slot];
+		slot = child_slot;
+	}
+	heap->entries[slot] = entry;
+
+	return result;
+}
+
+// Every node can be pushed once per incoming edge
+const int HPA_HEAP_CAPACITY = HPA_NODE_COUNT * (HPA_MAX_CLUSTER_NODE_COUNT + 1) + HPA_MAX_CLUSTER_NODE_COUNT;
+
+// Dijkstra over the abstract graph seeded with the start's steps to its cluster nodes. Nodes are
+// cluster_idx * HPA_MAX_CLUSTER_NODE_COUNT + node_idx. costs receives steps per node (UINT32_MAX when unreached),
+// parents (optional) the previous node or -1 for nodes entered straight from the start.
+uint64_t hpa_search(HpaGraph *graph, int start_cluster_idx, uint16_t *start_costs, uint32_t *costs, int *parents, uint64_t *heap_entries)
+{
+	uint64_t expanded_node_count = 0;
+
+	memset(costs, 0xFF, HPA_NODE_COUNT * sizeof(*costs));
+
+	HpaHeap open_list = {};
+	open_list.entries = heap_entries;
+
+	HpaCluster *start_cluster = &graph->clusters[start_cluster_idx];
+	for(int node_idx = 0; node_idx < start_cluster->node_count; ++node_idx)
+	{
+		if(start_costs[node_idx] != HPA_UNREACHABLE)
+		{
+			int node = start_cluster_idx * HPA_MAX_CLUSTER_NODE_COUNT + node_idx;
+
+			costs[node] = start_costs[node_idx];
+			if(parents)
+			{
+				parents[node] = -1;
+			}
+
+			hpa_heap_push(&open_list, ((uint64_t)costs[node] << 32) | node);
+		}
+	}
+
+	int cluster_offsets_x[] = {-1, 1,  0, 0};
+	int cluster_offsets_y[] = { 0, 0, -1, 1};
+	static_assert(HPA_BORDER_LEFT == 0 && HPA_BORDER_RIGHT == 1 && HPA_BORDER_TOP == 2 && HPA_BORDER_BOTTOM == 3);
+
+	while(open_list.count > 0)
+	{
+		uint64_t entry     = hpa_heap_pop(&open_list);
+		uint32_t curr_cost = (uint32_t)(entry >> 32);
+		int      curr_node = (int)(entry & 0xFFFFFFFF);
+
+		if(curr_cost > costs[curr_node])
+		{
+			continue;
+		}
+
+		++expanded_node_count;
+
+		int         cluster_idx = curr_node / HPA_MAX_CLUSTER_NODE_COUNT;
+		int         node_idx    = curr_node % HPA_MAX_CLUSTER_NODE_COUNT;
+		HpaCluster *cluster     = &graph->clusters[cluster_idx];
+
+		for(int neighbor_idx = 0; neighbor_idx < cluster->node_count; ++neighbor_idx)
+		{
+			uint16_t distance = cluster->distances[node_idx][neighbor_idx];
+			if(distance != HPA_UNREACHABLE)
+			{
+				int      neighbor_node = cluster_idx * HPA_MAX_CLUSTER_NODE_COUNT + neighbor_idx;
+				uint32_t neighbor_cost = curr_cost + distance;
+				if(neighbor_cost < costs[neighbor_node])
+				{
+					costs[neighbor_node] = neighbor_cost;
+					if(parents)
+					{
+						parents[neighbor_node] = curr_node;
+					}
+
+					hpa_heap_push(&open_list, ((uint64_t)neighbor_cost << 32) | neighbor_node);
+				}
+			}
+		}
+
+		// The step across the entrance
+		int border         = cluster->node_borders[node_idx];
+		int entrance_idx   = node_idx - cluster->border_node_starts[border];
+		int across_cluster = cluster_idx + cluster_offsets_y[border] * HPA_CLUSTER_COUNT_X + cluster_offsets_x[border];
+
+		HpaCluster *across = &graph->clusters[across_cluster];
+		assert(entrance_idx < across->border_node_counts[border ^ 1]);
+
+		int      across_node = across_cluster * HPA_MAX_CLUSTER_NODE_COUNT + across->border_node_starts[border ^ 1] + entrance_idx;
+		uint32_t across_cost = curr_cost + 1;
+		if(across_cost < costs[across_node])
+		{
+			costs[across_node] = across_cost;
+			if(parents)
+			{
+				parents[across_node] = curr_node;
+			}
+
+			hpa_heap_push(&open_list, ((uint64_t)across_cost << 32) | across_node);
+		}
+	}
+
+	return expanded_node_count;
+}
+
+// Steps from the searched start to a target, through whichever of the target cluster's nodes is best or straight
+// inside the cluster when both share one (best_node is -1 then). UINT32_MAX when unreachable.
+uint32_t hpa_get_target_cost(HpaGraph *graph, OccupancyMap *map, PathTile *start, uint16_t *start_labels, uint32_t *costs, PathTile *target, uint16_t *target_node_costs, int *best_node)
+{
+	uint32_t result = UINT32_MAX;
+	*best_node      = -1;
+
+	// Like the flood modes, a blocked target is never reached unless it is the start itself
+	bool is_start = start->x == target->x && start->y == target->y;
+	if(is_start || map_is_free(map, target->x, target->y))
+	{
+		int target_cluster_idx = hpa_get_cluster_idx(target->x, target->y);
+		if(target_cluster_idx == hpa_get_cluster_idx(start->x, start->y))
+		{
+			int label = start_labels[hpa_get_local_idx(target->x, target->y)];
+			if(label)
+			{
+				result = label - 1;
+			}
+		}
+
+		HpaCluster *target_cluster = &graph->clusters[target_cluster_idx];
+		for(int node_idx = 0; node_idx < target_cluster->node_count; ++node_idx)
+		{
+			int node = target_cluster_idx * HPA_MAX_CLUSTER_NODE_COUNT + node_idx;
+			if(target_node_costs[node_idx] != HPA_UNREACHABLE && costs[node] != UINT32_MAX && costs[node] + target_node_costs[node_idx] < result)
+			{
+				result     = costs[node] + target_node_costs[node_idx];
+				*best_node = node;
+			}
+		}
+	}
+
+	return result;
+}
+
+// Walks from one tile to another inside their shared cluster, appending every tile after from up to and including to
+bool hpa_append_local_path(HpaGraph *graph, OccupancyMap *map, PathTile from, PathTile to, PathTile *tiles, int *tile_count, int max_tile_count)
+{
+	uint16_t labels[HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE];
+	hpa_cluster_flood(graph, map, to.x, to.y, labels, NULL);
+
+	int cluster_x0 = (to.x / HPA_CLUSTER_SIZE) * HPA_CLUSTER_SIZE;
+	int cluster_y0 = (to.y / HPA_CLUSTER_SIZE) * HPA_CLUSTER_SIZE;
+
+	int neighbor_offsets_x[] = {1, 0, -1,  0};
+	int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+	bool     result = labels[hpa_get_local_idx(from.x, from.y)] > 0;
+	PathTile curr   = from;
+	while(result && labels[hpa_get_local_idx(curr.x, curr.y)] > 1)
+	{
+		int label = labels[hpa_get_local_idx(curr.x, curr.y)];
+		for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
+		{
+			PathTile neighbor = {curr.x + neighbor_offsets_x[neighbor_idx], curr.y + neighbor_offsets_y[neighbor_idx]};
+			if(neighbor.x >= cluster_x0 && neighbor.x < cluster_x0 + HPA_CLUSTER_SIZE && neighbor.y >= cluster_y0 && neighbor.y < cluster_y0 + HPA_CLUSTER_SIZE &&
+			   labels[hpa_get_local_idx(neighbor.x, neighbor.y)] == label - 1)
+			{
+				curr = neighbor;
+				break;
+			}
+		}
+
+		if(*tile_count < max_tile_count)
+		{
+			tiles[(*tile_count)++] = curr;
+		}else
+		{
+			result = false;
+		}
+	}
+	return result;
+}
+
+// Single source queries against an up to date graph, one abstract search serves every target
+void hpa_targets_internal(HpaGraph *graph, OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, FoundPaths *paths, int *tile_counts, PathFindStats *stats, Arena *arena)
+{
+	TmpArena scratch = arena_begin_scratch(&arena, 1);
+
+	uint32_t *costs        = arena_push_array(scratch.arena, HPA_NODE_COUNT, uint32_t);
+	int      *parents      = arena_push_array(scratch.arena, HPA_NODE_COUNT, int);
+	uint64_t *heap_entries = arena_push_array(scratch.arena, HPA_HEAP_CAPACITY, uint64_t);
+	int      *node_path    = arena_push_array(scratch.arena, HPA_NODE_COUNT, int);
+	PathTile *path_tiles   = arena_push_array(scratch.arena, MAP_W * MAP_H, PathTile);
+
+	uint16_t start_labels[HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE];
+	uint16_t start_node_costs[HPA_MAX_CLUSTER_NODE_COUNT];
+
+	PathTile start = {start_x, start_y};
+
+	uint64_t expanded_node_count = hpa_cluster_flood(graph, map, start_x, start_y, start_labels, start_node_costs);
+	expanded_node_count += hpa_search(graph, hpa_get_cluster_idx(start_x, start_y), start_node_costs, costs, paths ? parents : NULL, heap_entries);
+
+	for(int target_idx = 0; target_idx < target_count; ++target_idx)
+	{
+		PathTile *target = &targets[target_idx];
+
+		uint16_t target_labels[HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE];
+		uint16_t target_node_costs[HPA_MAX_CLUSTER_NODE_COUNT];
+		expanded_node_count += hpa_cluster_flood(graph, map, target->x, target->y, target_labels, target_node_costs);
+
+		int      best_node = -1;
+		uint32_t cost      = hpa_get_target_cost(graph, map, &start, start_labels, costs, target, target_node_costs, &best_node);
+
+		int tile_count = 0;
+		if(cost != UINT32_MAX && (int)cost + 1 <= max_step_count + 1)
+		{
+			tile_count = cost + 1;
+		}
+
+		if(tile_counts)
+		{
+			tile_counts[target_idx] = tile_count;
+		}
+
+		if(paths)
+		{
+			FoundPath *path = &paths->paths[paths->count++];
+			*path           = {};
+
+			if(tile_count > 0)
+			{
+				// Refine each abstract edge: entrance crossings are a single step, everything else stays in one cluster
+				int node_path_count = 0;
+				for(int node = best_node; node >= 0; node = parents[node])
+				{
+					node_path[node_path_count++] = node;
+				}
+
+				int path_tile_count = 0;
+				path_tiles[path_tile_count++] = start;
+
+				bool     is_complete = true;
+				PathTile curr        = start;
+				for(int node_path_idx = node_path_count - 1; node_path_idx >= 0 && is_complete; --node_path_idx)
+				{
+					int       node      = node_path[node_path_idx];
+					PathTile *node_tile = &graph->clusters[node / HPA_MAX_CLUSTER_NODE_COUNT].nodes[node % HPA_MAX_CLUSTER_NODE_COUNT];
+
+					if(hpa_get_cluster_idx(curr.x, curr.y) != hpa_get_cluster_idx(node_tile->x, node_tile->y))
+					{
+						path_tiles[path_tile_count++] = *node_tile;
+					}else
+					{
+						is_complete = hpa_append_local_path(graph, map, curr, *node_tile, path_tiles, &path_tile_count, MAP_W * MAP_H);
+					}
+					curr = *node_tile;
+				}
+
+				if(is_complete)
+				{
+					is_complete = hpa_append_local_path(graph, map, curr, *target, path_tiles, &path_tile_count, MAP_W * MAP_H);
+				}
+
+				if(is_complete)
+				{
+					assert(path_tile_count == tile_count);
+
+					path->tile_count = path_tile_count;
+					path->tiles      = arena_push_array(arena, path_tile_count, PathTile);
+					memcpy(path->tiles, path_tiles, path_tile_count * sizeof(PathTile));
+				}
+			}
+		}
+	}
+
+	if(stats)
+	{
+		++stats->search_count;
+		stats->expanded_node_count += expanded_node_count;
+		stats->cleared_byte_count  += HPA_NODE_COUNT * sizeof(*costs);
+	}
+
+	arena_end_scratch(scratch);
+}
+
+FoundPath hpa_path_find_target(HpaGraph *graph, OccupancyMap *map, int start_x, int start_y, int target_x, int target_y, int max_step_count, Arena *arena, PathFindStats *stats)
+{
+	PathTile target = {target_x, target_y};
+
+	FoundPath  result = {};
+	FoundPaths paths  = {};
+	paths.paths       = &result;
+
+	hpa_targets_internal(graph, map, start_x, start_y, &target, 1, max_step_count, &paths, NULL, stats, arena);
+
+	return result;
+}
+
+FoundPaths hpa_path_find_targets(HpaGraph *graph, OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, Arena *arena, PathFindStats *stats)
+{
+	FoundPaths result = {};
+	result.paths      = arena_push_array(arena, target_count, FoundPath);
+
+	hpa_targets_internal(graph, map, start_x, start_y, targets, target_count, max_step_count, &result, NULL, stats, arena);
+
+	return result;
+}
+
+void hpa_door_distances(HpaGraph *graph, OccupancyMap *map, PathTile *doors, int door_count, int max_step_count, int *distances, PathFindStats *stats)
+{
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	uint32_t *costs        = arena_push_array(scratch.arena, HPA_NODE_COUNT, uint32_t);
+	uint64_t *heap_entries = arena_push_array(scratch.arena, HPA_HEAP_CAPACITY, uint64_t);
+
+	// Every door is a start once and a target many times, its in-cluster floods are done up front
+	uint16_t *door_labels     = arena_push_array(scratch.arena, door_count * HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE, uint16_t);
+	uint16_t *door_node_costs = arena_push_array(scratch.arena, door_count * HPA_MAX_CLUSTER_NODE_COUNT, uint16_t);
+
+	uint64_t expanded_node_count = 0;
+	for(int door_idx = 0; door_idx < door_count; ++door_idx)
+	{
+		PathTile *door = &doors[door_idx];
+		expanded_node_count += hpa_cluster_flood(graph, map, door->x, door->y, &door_labels[door_idx * HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE], &door_node_costs[door_idx * HPA_MAX_CLUSTER_NODE_COUNT]);
+	}
+
+	for(int door_idx = 0; door_idx < door_count; ++door_idx)
+	{
+		PathTile *door = &doors[door_idx];
+
+		uint16_t *labels = &door_labels[door_idx * HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE];
+		expanded_node_count += hpa_search(graph, hpa_get_cluster_idx(door->x, door->y), &door_node_costs[door_idx * HPA_MAX_CLUSTER_NODE_COUNT], costs, NULL, heap_entries);
+
+		distances[door_idx * door_count + door_idx] = 0;
+
+		// The abstract graph is undirected, so the upper triangle is mirrored like path_find_door_distances
+		for(int target_idx = door_idx + 1; target_idx < door_count; ++target_idx)
+		{
+			int      best_node = -1;
+			uint32_t cost      = hpa_get_target_cost(graph, map, door, labels, costs, &doors[target_idx], &door_node_costs[target_idx * HPA_MAX_CLUSTER_NODE_COUNT], &best_node);
+
+			int tile_count = 0;
+			if(cost != UINT32_MAX && (int)cost + 1 <= max_step_count + 1)
+			{
+				tile_count = cost + 1;
+			}
+
+			distances[door_idx * door_count + target_idx] = tile_count;
+			distances[target_idx * door_count + door_idx] = tile_count;
+		}
+	}
+
+	if(stats)
+	{
+		stats->search_count        += door_count;
+		stats->expanded_node_count += expanded_node_count;
+		stats->cleared_byte_count  += door_count * HPA_NODE_COUNT * sizeof(*costs);
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// Breadth first distances from the start tile into one landmark slot of every tile, returns the visited tile count
+int landmark_flood(LandmarkFields *fields, OccupancyMap *map, int landmark_idx, PathTile start, uint16_t *queue)
+{
+	for(int tile_idx = 0; tile_idx < MAP_W * MAP_H; ++tile_idx)
+	{
+		fields->distances[tile_idx][landmark_idx] = 0;
+	}
+
+	int queue_front = 0;
+	int queue_back  = 0;
+
+	int start_idx = start.y * MAP_W + start.x;
+	fields->distances[start_idx][landmark_idx] = 1;
+	queue[queue_back++]                        = start_idx;
+
+	while(queue_front < queue_back)
+	{
+		int curr_idx      = queue[queue_front++];
+		int curr_distance = fields->distances[curr_idx][landmark_idx];
+
+		int curr_x = curr_idx % MAP_W;
+		int curr_y = curr_idx / MAP_W;
+
+		int neighbor_offsets_x[] = {1, 0, -1,  0};
+		int neighbor_offsets_y[] = {0, 1,  0, -1};
+
+		for(int neighbor_idx = 0; neighbor_idx < 4; ++neighbor_idx)
+		{
+			int neighbor_x = curr_x + neighbor_offsets_x[neighbor_idx];
+			int neighbor_y = curr_y + neighbor_offsets_y[neighbor_idx];
+
+			if(map_is_free(map, neighbor_x, neighbor_y))
+			{
+				int neighbor_tile_idx = neighbor_y * MAP_W + neighbor_x;
+				if(fields->distances[neighbor_tile_idx][landmark_idx] == 0)
+				{
+					fields->distances[neighbor_tile_idx][landmark_idx] = (uint16_t)(curr_distance + 1);
+					queue[queue_back++]                                = neighbor_tile_idx;
+				}
+			}
+		}
+	}
+
+	return queue_back;
+}
+
+void landmark_fields_build(LandmarkFields *fields, OccupancyMap *map, int landmark_count, PathFindStats *stats)
+{
+	if(landmark_count <= 0)
+	{
+		landmark_count = DEFAULT_LANDMARK_COUNT;
+	}
+
+	TmpArena  scratch = arena_begin_scratch(NULL, 0);
+	uint16_t *queue   = arena_push_array(scratch.arena, MAP_W * MAP_H, uint16_t);
+
+	uint64_t expanded_node_count = 0;
+
+	PathTile first_free = {-1, -1};
+	for(int tile_idx = 0; tile_idx < MAP_W * MAP_H && first_free.x < 0; ++tile_idx)
+	{
+		if(!occupancy_test(map, tile_idx % MAP_W, tile_idx / MAP_W))
+		{
+			first_free = {tile_idx % MAP_W, tile_idx / MAP_W};
+		}
+	}
+
+	fields->landmark_count = 0;
+	if(first_free.x >= 0)
+	{
+		// Slot 0 first holds the flood from the first free tile, the farthest tile from it becomes landmark 0
+		expanded_node_count += landmark_flood(fields, map, 0, first_free, queue);
+
+		for(int landmark_idx = 0; landmark_idx < min(landmark_count, MAX_LANDMARK_COUNT); ++landmark_idx)
+		{
+			// The tile farthest from its nearest landmark so far, unreached tiles are never picked
+			int best_tile_idx = -1;
+			int best_distance = 0;
+
+			int used_slot_count = max(landmark_idx, 1);
+			for(int tile_idx = 0; tile_idx < MAP_W * MAP_H; ++tile_idx)
+			{
+				uint16_t *distances = fields->distances[tile_idx];
+
+				int distance = distances[0];
+				for(int slot_idx = 1; slot_idx < used_slot_count; ++slot_idx)
+				{
+					distance = min(distance, (int)distances[slot_idx]);
+				}
+
+				if(distance > best_distance)
+				{
+					best_tile_idx = tile_idx;
+					best_distance = distance;
+				}
+			}
+
+			PathTile landmark = {best_tile_idx % MAP_W, best_tile_idx / MAP_W};
+
+			fields->landmarks[landmark_idx] = landmark;
+			fields->landmark_count          = landmark_idx + 1;
+
+			expanded_node_count += landmark_flood(fields, map, landmark_idx, landmark, queue);
+		}
+	}
+
+	if(stats)
+	{
+		stats->search_count        += fields->landmark_count + 1;
+		stats->expanded_node_count += expanded_node_count;
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// Largest landmark bound on the distance between the two tiles, landmarks that cannot reach both give none
+int landmark_fields_get_bound(LandmarkFields *fields, int x, int y, int target_x, int target_y)
+{
+	uint16_t *distances        = fields->distances[y * MAP_W + x];
+	uint16_t *target_distances = fields->distances[target_y * MAP_W + target_x];
+
+	int result = 0;
+	for(int landmark_idx = 0; landmark_idx < fields->landmark_count; ++landmark_idx)
+	{
+		int distance        = distances[landmark_idx];
+		int target_distance = target_distances[landmark_idx];
+
+		if(distance && target_distance)
+		{
+			result = max(result, abs(distance - target_distance));
+		}
+	}
+
+	return result;
+}
+
+// Picks the policy's template instance of the A* or JPS loop
+template <typename Queue, bool use_jump_points>
+void path_find_targets_policy_dispatch(OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, FoundPaths *paths, int *tile_counts, PathFindOptions *options, Arena *arena, LandmarkFields *landmarks = NULL)
+{
+	int weight = (int)(options->weight * PATH_FIND_WEIGHT_ONE + 0.5f);
+	weight     = min(max(weight, PATH_FIND_WEIGHT_ONE), PATH_FIND_MAX_WEIGHT * PATH_FIND_WEIGHT_ONE);
+
+	switch(options->policy)
+	{
+		case PATH_FIND_POLICY_WEIGHTED:
+			path_find_targets_internal<Queue, use_jump_points, PATH_FIND_POLICY_WEIGHTED>(map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, weight, landmarks, options->stats, arena);
+			break;
+
+		case PATH_FIND_POLICY_GREEDY:
+			path_find_targets_internal<Queue, use_jump_points, PATH_FIND_POLICY_GREEDY>(map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, weight, landmarks, options->stats, arena);
+			break;
+
+		default:
+			path_find_targets_internal<Queue, use_jump_points, PATH_FIND_POLICY_OPTIMAL>(map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, weight, landmarks, options->stats, arena);
+	}
+}
+
+// The pool's graph brought in line with the map, rebuilt only when the map differs from the one it was last built for
+HpaGraph *grid_node_pool_get_hpa_graph(GridNodePool *pool, OccupancyMap *map, PathFindStats *stats)
+{
+	if(!pool->is_hpa_graph_built || memcmp(pool->hpa_graph_map, map, sizeof(OccupancyMap)) != 0)
+	{
+		hpa_graph_update(pool->hpa_graph, map, NULL, stats);
+
+		*pool->hpa_graph_map     = *map;
+		pool->is_hpa_graph_built = true;
+	}
+
+	HpaGraph *result = pool->hpa_graph;
+	return result;
+}
+
+// Same for the pool's landmarks, the landmark count has to match too
+LandmarkFields *grid_node_pool_get_landmark_fields(GridNodePool *pool, OccupancyMap *map, int landmark_count, PathFindStats *stats)
+{
+	if(!pool->is_landmark_fields_built || pool->landmark_fields_count != landmark_count || memcmp(pool->landmark_fields_map, map, sizeof(OccupancyMap)) != 0)
+	{
+		landmark_fields_build(pool->landmark_fields, map, landmark_count, stats);
+
+		*pool->landmark_fields_map     = *map;
+		pool->landmark_fields_count    = landmark_count;
+		pool->is_landmark_fields_built = true;
+	}
+
+	LandmarkFields *result = pool->landmark_fields;
+	return result;
+}
+
+// Picks the template instance for the options. Modes that cannot produce tiles fall back to A* when paths are requested.
+void path_find_targets_dispatch(OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, FoundPaths *paths, int *tile_counts, PathFootprint *footprints, PathFindOptions *options, Arena *arena)
+{
+	PathFindOptions default_options = {};
+	if(!options)
+	{
+		options = &default_options;
+	}
+
+	PathFindMode mode = options->mode;
+	if(paths && mode != PATH_FIND_MODE_JPS && mode != PATH_FIND_MODE_SOA && mode != PATH_FIND_MODE_HPA && mode != PATH_FIND_MODE_ALT)
+	{
+		mode = PATH_FIND_MODE_A_STAR;
+	}
+
+	bool use_buckets = options->queue == PATH_FIND_QUEUE_BUCKET;
+
+	if(options->bidirectional && mode == PATH_FIND_MODE_A_STAR && options->policy == PATH_FIND_POLICY_OPTIMAL)
+	{
+		for(int target_idx = 0; target_idx < target_count; ++target_idx)
+		{
+			PathTile *target = &targets[target_idx];
+			int      *target_tile_count = tile_counts ? &tile_counts[target_idx] : NULL;
+
+			if(use_buckets)
+			{
+				path_find_bidirectional_internal<GridNodeBuckets>(map, start_x, start_y, target->x, target->y, max_step_count, paths, target_tile_count, options->stats, arena);
+			}else
+			{
+				path_find_bidirectional_internal<GridNodeHeap>(map, start_x, start_y, target->x, target->y, max_step_count, paths, target_tile_count, options->stats, arena);
+			}
+		}
+		return;
+	}
+
+	switch(mode)
+	{
+		case PATH_FIND_MODE_FLOOD:
+			path_find_flood_internal(map, start_x, start_y, targets, target_count, max_step_count, tile_counts, options->stats, footprints);
+			break;
+
+		case PATH_FIND_MODE_BITS:
+		case PATH_FIND_MODE_MULTI:
+		case PATH_FIND_MODE_LOCKSTEP:
+		{
+			TmpArena scratch   = arena_begin_scratch(NULL, 0);
+			MapBits  *free_bits = arena_push_array(scratch.arena, 1, MapBits);
+
+			map_bits_from_occupancy(free_bits, map);
+			path_find_bits_internal(free_bits, start_x, start_y, targets, target_count, max_step_count, tile_counts, options->stats, footprints);
+
+			arena_end_scratch(scratch);
+		}break;
+
+		case PATH_FIND_MODE_HPA:
+		{
+			HpaGraph *graph = grid_node_pool_get_hpa_graph(grid_node_pool_get(), map, options->stats);
+
+			hpa_targets_internal(graph, map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, options->stats, arena);
+		}break;
+
+		case PATH_FIND_MODE_SOA:
+			path_find_compact_internal(map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, options->stats, arena);
+			break;
+
+		case PATH_FIND_MODE_ALT:
+		{
+			LandmarkFields *landmarks = grid_node_pool_get_landmark_fields(grid_node_pool_get(), map, options->landmark_count, options->stats);
+
+			path_find_targets_policy_dispatch<GridNodeHeap, false>(map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, options, arena, landmarks);
+		}break;
+
+		case PATH_FIND_MODE_JPS:
+			if(use_buckets)
+			{
+				path_find_targets_policy_dispatch<GridNodeBuckets, true>(map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, options, arena);
+			}else
+			{
+				path_find_targets_policy_dispatch<GridNodeHeap, true>(map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, options, arena);
+			}
+			break;
+
+		default:
+			if(use_buckets)
+			{
+				path_find_targets_policy_dispatch<GridNodeBuckets, false>(map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, options, arena);
+			}else
+			{
+				path_find_targets_policy_dispatch<GridNodeHeap, false>(map, start_x, start_y, targets, target_count, max_step_count, paths, tile_counts, options, arena);
+			}
+	}
+}
+
+FoundPaths path_find_targets(OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, Arena *arena, PathFindOptions *options)
+{
+	FoundPaths result = {};
+	result.paths      = arena_push_array(arena, target_count, FoundPath);
+
+	path_find_targets_dispatch(map, start_x, start_y, targets, target_count, max_step_count, &result, NULL, NULL, options, arena);
+
+	return result;
+}
+
+void path_find_target_distances(OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, int *tile_counts, PathFindOptions *options, PathFootprint *footprints)
+{
+	path_find_targets_dispatch(map, start_x, start_y, targets, target_count, max_step_count, NULL, tile_counts, footprints, options, NULL);
+}
+
+void path_find_door_distances(OccupancyMap *map, PathTile *doors, int door_count, int max_step_count, int *distances, PathFindOptions *options, PathFootprint *footprints)
+{
+	if(options && options->mode == PATH_FIND_MODE_MULTI && door_count <= MAX_MULTI_SOURCE_COUNT)
+	{
+		path_find_multi_source_internal(map, doors, door_count, max_step_count, distances, options->stats);
+		return;
+	}
+
+	if(options && options->mode == PATH_FIND_MODE_LOCKSTEP)
+	{
+		path_find_lockstep_door_distances(&map, &doors, &door_count, 1, max_step_count, &distances, options->stats);
+		return;
+	}
+
+	if(options && options->mode == PATH_FIND_MODE_HPA)
+	{
+		HpaGraph *graph = grid_node_pool_get_hpa_graph(grid_node_pool_get(), map, options->stats);
+
+		hpa_door_distances(graph, map, doors, door_count, max_step_count, distances, options->stats);
+		return;
+	}
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	// The bitset map or the landmarks are shared by every source
+	MapBits *free_bits = NULL;
+	if(options && (options->mode == PATH_FIND_MODE_BITS || options->mode == PATH_FIND_MODE_MULTI))
+	{
+		free_bits = arena_push_array(scratch.arena, 1, MapBits);
+		map_bits_from_occupancy(free_bits, map);
+	}
+
+	LandmarkFields *landmarks = NULL;
+	if(options && options->mode == PATH_FIND_MODE_ALT)
+	{
+		landmarks = grid_node_pool_get_landmark_fields(grid_node_pool_get(), map, options->landmark_count, options->stats);
+	}
+
+	for(int door_idx = 0; door_idx < door_count; ++door_idx)
+	{
+		PathTile *door = &doors[door_idx];
+
+		int *row = &distances[door_idx * door_count];
+		row[door_idx] = 0;
+
+		int            target_offset  = door_idx + 1;
+		PathFootprint *row_footprints = footprints ? &footprints[door_idx * door_count + target_offset] : NULL;
+		if(free_bits)
+		{
+			path_find_bits_internal(free_bits, door->x, door->y, doors + target_offset, door_count - target_offset, max_step_count, row + target_offset, options->stats, row_footprints);
+		}else if(landmarks)
+		{
+			path_find_targets_policy_dispatch<GridNodeHeap, false>(map, door->x, door->y, doors + target_offset, door_count - target_offset, max_step_count, NULL, row + target_offset, options, NULL, landmarks);
+		}else
+		{
+			path_find_target_distances(map, door->x, door->y, doors + target_offset, door_count - target_offset, max_step_count, row + target_offset, options, row_footprints);
+		}
+
+		// Mirror into the lower triangle so either index order can be looked up
+		for(int target_idx = target_offset; target_idx < door_count; ++target_idx)
+		{
+			distances[target_idx * door_count + door_idx] = row[target_idx];
+		}
+	}
+
+	arena_end_scratch(scratch);
+}
+
+FoundPath path_find_target(OccupancyMap *map, int start_x, int start_y, int target_x, int target_y, int max_step_count, Arena *arena, PathFindOptions *options)
+{
+	PathTile   target = {target_x, target_y};
+	FoundPaths paths  = path_find_targets(map, start_x, start_y, &target, 1, max_step_count, arena, options);
+
+	assert(paths.count == 1);
+
+	FoundPath result = paths.paths[0];
+	return result;
+}
+
+void path_find_batch(PathFindJob *jobs, int job_count, int max_step_count, PathFindOptions *options)
+{
+	PathFindOptions default_options = {};
+	if(!options)
+	{
+		options = &default_options;
+	}
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	MapBits        *free_bits = arena_push_array(scratch.arena, 1, MapBits);
+	HpaGraph       *graph     = NULL;
+	LandmarkFields *landmarks = NULL;
+
+	// Map the shared state was last set up for
+	OccupancyMap *setup_map = NULL;
+
+	for(int job_idx = 0; job_idx < job_count; ++job_idx)
+	{
+		PathFindJob *job = &jobs[job_idx];
+
+		switch(options->mode)
+		{
+			case PATH_FIND_MODE_BITS:
+			case PATH_FIND_MODE_MULTI:
+			case PATH_FIND_MODE_LOCKSTEP:
+				if(job->map != setup_map)
+				{
+					map_bits_from_occupancy(free_bits, job->map);
+				}
+
+				path_find_bits_internal(free_bits, job->start.x, job->start.y, job->targets, job->target_count, max_step_count, job->tile_counts, options->stats, NULL);
+				break;
+
+			case PATH_FIND_MODE_HPA:
+				if(job->map != setup_map)
+				{
+					graph = grid_node_pool_get_hpa_graph(grid_node_pool_get(), job->map, options->stats);
+				}
+
+				hpa_targets_internal(graph, job->map, job->start.x, job->start.y, job->targets, job->target_count, max_step_count, NULL, job->tile_counts, options->stats, NULL);
+				break;
+
+			case PATH_FIND_MODE_ALT:
+				if(job->map != setup_map)
+				{
+					landmarks = grid_node_pool_get_landmark_fields(grid_node_pool_get(), job->map, options->landmark_count, options->stats);
+				}
+
+				path_find_targets_policy_dispatch<GridNodeHeap, false>(job->map, job->start.x, job->start.y, job->targets, job->target_count, max_step_count, NULL, job->tile_counts, options, NULL, landmarks);
+				break;
+
+			default:
+				path_find_targets_dispatch(job->map, job->start.x, job->start.y, job->targets, job->target_count, max_step_count, NULL, job->tile_counts, NULL, options, NULL);
+		}
+
+		setup_map = job->map;
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// Occluded fills: every seed bit spreads through the run of free tiles it sits in, towards higher or lower x.
+// Six shift steps cover a word, the run is carried over into the next word.
+void map_row_fill_towards_higher_x(uint64_t *row, uint64_t *free_row)
+{
+	uint64_t carry = 0;
+	for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+	{
+		uint64_t propagate = free_row[word_idx];
+		uint64_t generate  = row[word_idx] | (carry & propagate);
+
+		generate |= propagate & (generate << 1);  propagate &= propagate << 1;
+		generate |= propagate & (generate << 2);  propagate &= propagate << 2;
+		generate |= propagate & (generate << 4);  propagate &= propagate << 4;
+		generate |= propagate & (generate << 8);  propagate &= propagate << 8;
+		generate |= propagate & (generate << 16); propagate &= propagate << 16;
+		generate |= propagate & (generate << 32);
+
+		row[word_idx] = generate;
+		carry         = generate >> 63;
+	}
+}
+
+void map_row_fill_towards_lower_x(uint64_t *row, uint64_t *free_row)
+{
+	uint64_t carry = 0;
+	for(int word_idx = MAP_ROW_WORD_COUNT - 1; word_idx >= 0; --word_idx)
+	{
+		uint64_t propagate = free_row[word_idx];
+		uint64_t generate  = row[word_idx] | (carry & propagate);
+
+		generate |= propagate & (generate >> 1);  propagate &= propagate >> 1;
+		generate |= propagate & (generate >> 2);  propagate &= propagate >> 2;
+		generate |= propagate & (generate >> 4);  propagate &= propagate >> 4;
+		generate |= propagate & (generate >> 8);  propagate &= propagate >> 8;
+		generate |= propagate & (generate >> 16); propagate &= propagate >> 16;
+		generate |= propagate & (generate >> 32);
+
+		row[word_idx] = generate;
+		carry         = generate << 63;
+	}
+}
+
+// Marks in reach every tile a path from (x, y) gets to while only stepping dir_x horizontally and dir_y vertically,
+// one row at a time. Returns the last row reached, rows past it are left untouched.
+int visibility_sweep(MapBits *free_bits, int x, int y, int dir_x, int dir_y, MapBits *reach)
+{
+	uint64_t row[MAP_ROW_WORD_COUNT] = {};
+	row[x / 64] = 1ull << (x % 64);
+
+	int result = y;
+	for(int row_y = y; row_y >= 0 && row_y < MAP_H; row_y += dir_y)
+	{
+		if(row_y != y)
+		{
+			uint64_t any_bits = 0;
+			for(int word_idx = 0; word_idx < MAP_ROW_WORD_COUNT; ++word_idx)
+			{
+				row[word_idx] &= free_bits->rows[row_y][word_idx];
+				any_bits      |= row[word_idx];
+			}
+
+			if(!any_bits)
+			{
+				break;
+			}
+		}
+
+		if(dir_x > 0)
+		{
+			map_row_fill_towards_higher_x(row, free_bits->rows[row_y]);
+		}else
+		{
+			map_row_fill_towards_lower_x(row, free_bits->rows[row_y]);
+		}
+
+		memcpy(reach->rows[row_y], row, sizeof(row));
+		result = row_y;
+	}
+
+	return result;
+}
+
+bool visibility_node_is_valid(VisibilityGraph *graph, int node_idx)
+{
+	bool result = (graph->valid_nodes[node_idx / 64] >> (node_idx % 64)) & 1;
+	return result;
+}
+
+void visibility_set_edge(VisibilityGraph *graph, int a, int b, bool is_connected)
+{
+	if(is_connected)
+	{
+		graph->edges[a][b / 64] |= 1ull << (b % 64);
+		graph->edges[b][a / 64] |= 1ull << (a % 64);
+	}else
+	{
+		graph->edges[a][b / 64] &= ~(1ull << (b % 64));
+		graph->edges[b][a / 64] &= ~(1ull << (a % 64));
+	}
+}
+
+bool visibility_quadrant_contains(PathTile *origin, int dir_x, int dir_y, int x, int y)
+{
+	bool result = (x - origin->x) * dir_x >= 0 && (y - origin->y) * dir_y >= 0;
+	return result;
+}
+
+bool visibility_quadrant_overlaps(PathTile *origin, int dir_x, int dir_y, MapRect *rect)
+{
+	bool overlaps_x = dir_x > 0 ? rect->x1 > origin->x : rect->x0 <= origin->x;
+	bool overlaps_y = dir_y > 0 ? rect->y1 > origin->y : rect->y0 <= origin->y;
+
+	bool result = rect->x0 < rect->x1 && rect->y0 < rect->y1 && overlaps_x && overlaps_y;
+	return result;
+}
+
+// Sweeps one quadrant of a node and sets the edge to every valid node in it that is also in target_nodes
+uint64_t visibility_connect_quadrant(VisibilityGraph *graph, int node_idx, int dir_x, int dir_y, uint64_t *target_nodes, MapBits *reach)
+{
+	PathTile *node = &graph->nodes[node_idx];
+
+	int last_row = visibility_sweep(&graph->free_bits, node->x, node->y, dir_x, dir_y, reach);
+
+	int node_count = 5 * graph->rect_count;
+	for(int other_idx = 0; other_idx < node_count; ++other_idx)
+	{
+		PathTile *other = &graph->nodes[other_idx];
+		if(other_idx != node_idx && ((target_nodes[other_idx / 64] >> (other_idx % 64)) & 1) && visibility_quadrant_contains(node, dir_x, dir_y, other->x, other->y))
+		{
+			bool is_swept     = (other->y - last_row) * dir_y <= 0;
+			bool is_connected = is_swept && map_bits_test(reach, other->x, other->y);
+
+			visibility_set_edge(graph, node_idx, other_idx, is_connected);
+		}
+	}
+
+	uint64_t result = abs(last_row - node->y) + 1;
+	return result;
+}
+
+void visibility_graph_update(VisibilityGraph *graph, OccupancyMap *map, MapRect *rects, PathTile *doors, int rect_count, PathFindStats *stats)
+{
+	assert(rect_count <= VISIBILITY_MAX_RECT_COUNT);
+
+	TmpArena scratch = arena_begin_scratch(NULL, 0);
+
+	MapRect *changed_rects      = arena_push_array(scratch.arena, 2 * rect_count, MapRect);
+	int      changed_rect_count = 0;
+
+	uint64_t moved_nodes[VISIBILITY_NODE_WORD_COUNT] = {};
+
+	// Past half the rectangles a rebuild sweeps fewer quadrants than the update would
+	bool is_rebuild = rect_count != graph->rect_count;
+	if(!is_rebuild)
+	{
+		int changed_station_count = 0;
+		for(int rect_idx = 0; rect_idx < rect_count; ++rect_idx)
+		{
+			changed_station_count += memcmp(&rects[rect_idx], &graph->rects[rect_idx], sizeof(MapRect)) != 0;
+		}
+		is_rebuild = changed_station_count * 2 > rect_count;
+	}
+
+	if(is_rebuild)
+	{
+		mem_zero(graph->edges,       sizeof(graph->edges));
+		mem_zero(graph->valid_nodes, sizeof(graph->valid_nodes));
+		mem_zero(graph->rects,       sizeof(graph->rects));
+
+		graph->rect_count = rect_count;
+		for(int node_idx = 0; node_idx < 5 * rect_count; ++node_idx)
+		{
+			moved_nodes[node_idx / 64] |= 1ull << (node_idx % 64);
+		}
+	}
+
+	for(int rect_idx = 0; rect_idx < rect_count; ++rect_idx)
+	{
+		MapRect *rect     = &rects[rect_idx];
+		MapRect *old_rect = &graph->rects[rect_idx];
+
+		if(memcmp(rect, old_rect, sizeof(MapRect)) != 0)
+		{
+			if(!is_rebuild)
+			{
+				changed_rects[changed_rect_count++] = *old_rect;
+				changed_rects[changed_rect_count++] = *rect;
+			}
+
+			for(int corner_idx = 0; corner_idx < 4; ++corner_idx)
+			{
+				int node_idx = rect_count + 4 * rect_idx + corner_idx;
+				moved_nodes[node_idx / 64] |= 1ull << (node_idx % 64);
+			}
+			*old_rect = *rect;
+		}
+
+		PathTile *door = &graph->nodes[rect_idx];
+		if(door->x != doors[rect_idx].x || door->y != doors[rect_idx].y)
+		{
+			moved_nodes[rect_idx / 64] |= 1ull << (rect_idx % 64);
+			*door = doors[rect_idx];
+		}
+	}
+
+	int node_count = 5 * rect_count;
+	for(int node_idx = 0; node_idx < node_count; ++node_idx)
+	{
+		// Nodes under a changed rectangle may have been covered or uncovered, they are redone like moved ones
+		PathTile *node = &graph->nodes[node_idx];
+		for(int changed_idx = 0; changed_idx < changed_rect_count; ++changed_idx)
+		{
+			MapRect *rect = &changed_rects[changed_idx];
+			if(node->x >= rect->x0 && node->x < rect->x1 && node->y >= rect->y0 && node->y < rect->y1)
+			{
+				moved_nodes[node_idx / 64] |= 1ull << (node_idx % 64);
+			}
+		}
+	}
+
+	uint64_t any_moved_nodes = 0;
+	for(int word_idx = 0; word_idx < VISIBILITY_NODE_WORD_COUNT; ++word_idx)
+	{
+		any_moved_nodes |= moved_nodes[word_idx];
+	}
+
+	uint64_t swept_row_count = 0;
+	if(any_moved_nodes)
+	{
+		map_bits_from_occupancy(&graph->free_bits, map);
+
+		uint64_t stable_nodes[VISIBILITY_NODE_WORD_COUNT] = {};
+
+		for(int node_idx = 0; node_idx < node_count; ++node_idx)
+		{
+			uint64_t node_bit = 1ull << (node_idx % 64);
+			if(moved_nodes[node_idx / 64] & node_bit)
+			{
+				if(node_idx >= rect_count)
+				{
+					int      corner_idx = (node_idx - rect_count) % 4;
+					MapRect *rect       = &rects[(node_idx - rect_count) / 4];
+
+					PathTile *corner = &graph->nodes[node_idx];
+					corner->x        = corner_idx & 1 ? rect->x1 : rect->x0 - 1;
+					corner->y        = corner_idx & 2 ? rect->y1 : rect->y0 - 1;
+				}
+
+				// Drop the node's old edges, they are all redone below
+				for(int other_idx = 0; other_idx < node_count; ++other_idx)
+				{
+					visibility_set_edge(graph, node_idx, other_idx, false);
+				}
+
+				PathTile *node     = &graph->nodes[node_idx];
+				bool      is_valid = node_idx < rect_count || map_is_free(map, node->x, node->y);
+
+				graph->valid_nodes[node_idx / 64] &= ~node_bit;
+				graph->valid_nodes[node_idx / 64] |= is_valid ? node_bit : 0;
+			}else
+			{
+				stable_nodes[node_idx / 64] |= node_bit;
+			}
+		}
+
+		MapBits *reach = arena_push_array(scratch.arena, 1, MapBits);
+		for(int node_idx = 0; node_idx < node_count; ++node_idx)
+		{
+			if(!visibility_node_is_valid(graph, node_idx))
+			{
+				continue;
+			}
+
+			// Edges are symmetric, so sweeping towards higher y from every node covers each pair. Moved nodes are
+			// swept both ways against everything, stable nodes only where a changed rectangle can matter.
+			PathTile *node     = &graph->nodes[node_idx];
+			bool      is_moved = (moved_nodes[node_idx / 64] >> (node_idx % 64)) & 1;
+			if(is_rebuild)
+			{
+				swept_row_count += visibility_connect_quadrant(graph, node_idx,  1, 1, graph->valid_nodes, reach);
+				swept_row_count += visibility_connect_quadrant(graph, node_idx, -1, 1, graph->valid_nodes, reach);
+			}else if(is_moved)
+			{
+				for(int quadrant_idx = 0; quadrant_idx < 4; ++quadrant_idx)
+				{
+					int dir_x = quadrant_idx & 1 ? -1 : 1;
+					int dir_y = quadrant_idx & 2 ? -1 : 1;
+
+					swept_row_count += visibility_connect_quadrant(graph, node_idx, dir_x, dir_y, graph->valid_nodes, reach);
+				}
+			}else
+			{
+				uint64_t stable_valid_nodes[VISIBILITY_NODE_WORD_COUNT];
+				for(int word_idx = 0; word_idx < VISIBILITY_NODE_WORD_COUNT; ++word_idx)
+				{
+					stable_valid_nodes[word_idx] = stable_nodes[word_idx] & graph->valid_nodes[word_idx];
+				}
+
+				for(int dir_x = -1; dir_x <= 1; dir_x += 2)
+				{
+					bool is_affected = false;
+					for(int changed_idx = 0; changed_idx < changed_rect_count && !is_affected; ++changed_idx)
+					{
+						is_affected = visibility_quadrant_overlaps(node, dir_x, 1, &changed_rects[changed_idx]);
+					}
+
+					if(is_affected)
+					{
+						swept_row_count += visibility_connect_quadrant(graph, node_idx, dir_x, 1, stable_valid_nodes, reach);
+					}
+				}
+			}
+		}
+	}
+
+	if(stats)
+	{
+		++stats->search_count;
+		stats->expanded_node_count += swept_row_count;
+	}
+
+	arena_end_scratch(scratch);
+}
+
+// A* over the graph, Manhattan distance is a consistent heuristic for Manhattan edge lengths
+uint32_t visibility_search(VisibilityGraph *graph, int start_idx, int target_idx, uint64_t *heap_entries, uint64_t *expanded_node_count)
+{
+	int node_count = 5 * graph->rect_count;
+
+	uint32_t g_values[VISIBILITY_MAX_NODE_COUNT];
+	uint64_t closed[VISIBILITY_NODE_WORD_COUNT] = {};
+	memset(g_values, 0xFF, node_count * sizeof(*g_values));
+
+	PathTile *target = &graph->nodes[target_idx];
+
+	HpaHeap open_list = {};
+	open_list.entries = heap_entries;
+
+	PathTile *start = &graph->nodes[start_idx];
+	g_values[start_idx] = 0;
+	hpa_heap_push(&open_list, ((uint64_t)(abs(target->x - start->x) + abs(target->y - start->y)) << 32) | start_idx);
+
+	uint32_t result = UINT32_MAX;
+	while(open_list.count > 0)
+	{
+		int curr_idx = (int)(hpa_heap_pop(&open_list) & 0xFFFFFFFF);
+		if((closed[curr_idx / 64] >> (curr_idx % 64)) & 1)
+		{
+			continue;
+		}
+
+		closed[curr_idx / 64] |= 1ull << (curr_idx % 64);
+		++*expanded_node_count;
+
+		if(curr_idx == target_idx)
+		{
+			result = g_values[curr_idx];
+			break;
+		}
+
+		PathTile *curr = &graph->nodes[curr_idx];
+		for(int word_idx = 0; word_idx < VISIBILITY_NODE_WORD_COUNT; ++word_idx)
+		{
+			uint64_t neighbors = graph->edges[curr_idx][word_idx] & ~closed[word_idx];
+			while(neighbors)
+			{
+				unsigned long bit_idx;
+				_BitScanForward64(&bit_idx, neighbors);
+				neighbors &= neighbors - 1;
+
+				int       neighbor_idx = word_idx * 64 + bit_idx;
+				PathTile *neighbor     = &graph->nodes[neighbor_idx];
+				uint32_t  g            = g_values[curr_idx] + abs(neighbor->x - curr->x) + abs(neighbor->y - curr->y);
+
+				if(g < g_values[neighbor_idx])
+				{
+					g_values[neighbor_idx] = g;
+
+					uint32_t f = g + abs(target->x - neighbor->x) + abs(target->y - neighbor->y);
+					hpa_heap_push(&open_list, ((uint64_t)f << 32) | neighbor_idx);
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+void visibility_door_distances(VisibilityGraph *graph, int max_step_count, int *distances, PathFindStats *stats)
+{
+	uint64_t *heap_entries = grid_node_pool_get()->visibility_heap;
+
+	int door_count = graph->rect_count;
+
+	uint64_t search_count        = 0;
+	uint64_t expanded_node_count = 0;
+	for(int door_idx = 0; door_idx < door_count; ++door_idx)
+	{
+		PathTile *door = &graph->nodes[door_idx];
+
+		distances[door_idx * door_count + door_idx] = 0;
+		for(int target_idx = door_idx + 1; target_idx < door_count; ++target_idx)
+		{
+			// A direct edge is a monotone path, nothing can beat its Manhattan length. Only the rest need a search.
+			uint32_t distance = UINT32_MAX;
+			if((graph->edges[door_idx][target_idx / 64] >> (target_idx % 64)) & 1)
+			{
+				PathTile *target = &graph->nodes[target_idx];
+				distance         = abs(target->x - door->x) + abs(target->y - door->y);
+			}else
+			{
+				distance = visibility_search(graph, door_idx, target_idx, heap_entries, &expanded_node_count);
+				++search_count;
+			}
+
+			int tile_count = 0;
+			if(distance != UINT32_MAX && (int)distance + 1 <= max_step_count + 1)
+			{
+				tile_count = distance + 1;
+			}
+
+			distances[door_idx * door_count + target_idx] = tile_count;
+			distances[target_idx * door_count + door_idx] = tile_count;
+		}
+	}
+
+	if(stats)
+	{
+		stats->search_count        += search_count;
+		stats->expanded_node_count += expanded_node_count;
+	}
+}
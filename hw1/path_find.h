@@ -7,7 +7,200 @@ const int MAP_H = 128;
 
 const int GRID_NODE_HEAP_CAPACITY = MAP_W * MAP_H;
 
-typedef int MapTile;
+// Weighted A* scales h by a fixed point weight, 1 << PATH_FIND_WEIGHT_SHIFT is a weight of 1
+const int PATH_FIND_WEIGHT_SHIFT = 4;
+const int PATH_FIND_WEIGHT_ONE   = 1 << PATH_FIND_WEIGHT_SHIFT;
+const int PATH_FIND_MAX_WEIGHT   = 4;
+
+// Largest f value is a full length path plus the (weighted) Manhattan distance across the map
+const int GRID_NODE_BUCKET_COUNT = MAP_W * MAP_H + PATH_FIND_MAX_WEIGHT * (MAP_W + MAP_H);
+
+// One bit per tile, tile x of a row is bit x % 64 of word x / 64
+const int MAP_ROW_WORD_COUNT = MAP_W / 64;
+
+// Sources a single multi-source sweep can carry, one bit each
+const int MAX_MULTI_SOURCE_COUNT = 64;
+
+// Maps a lockstep sweep advances together, one vector lane each (8 x 64 bits fills two AVX2 registers)
+const int MAX_LOCKSTEP_LANE_COUNT = 8;
+static_assert(MAP_W % 64 == 0);
+
+struct MapBits
+{
+	uint64_t rows[MAP_H][MAP_ROW_WORD_COUNT];
+};
+
+// The map searches run on, in the MapBits layout but set bits are blocked tiles so that a zeroed map is empty
+struct OccupancyMap
+{
+	uint64_t rows[MAP_H][MAP_ROW_WORD_COUNT];
+};
+
+enum PathFindMode
+{
+	PATH_FIND_MODE_A_STAR, // Multi-target A* reusing the open list between targets
+	PATH_FIND_MODE_FLOOD,  // One breadth first sweep per source labelling every target
+	PATH_FIND_MODE_JPS,    // A* over 4-connected jump points, only scan-line stops are pushed to the open list
+	PATH_FIND_MODE_BITS,   // Breadth first waves over MapBits, each wave expands whole rows with shifts and masks
+	PATH_FIND_MODE_MULTI,  // Multi-source BFS, up to 64 doors advance together as bits of one word per tile
+	PATH_FIND_MODE_SOA,    // Same A* as PATH_FIND_MODE_A_STAR over compact structure-of-arrays node storage
+	PATH_FIND_MODE_HPA,    // Hierarchical, Dijkstra over cluster entrances then refined inside clusters. Not exact
+	PATH_FIND_MODE_VISIBILITY, // Dijkstra over doors and station corners, given the station rectangles (see VisibilityGraph), else A*
+	PATH_FIND_MODE_LOCKSTEP,   // PATH_FIND_MODE_BITS waves for several factories at once, see path_find_lockstep_door_distances
+	PATH_FIND_MODE_ALT,        // A* with landmark lower bounds on top of Manhattan distance (see LandmarkFields), always on the heap
+
+	PATH_FIND_MODE_COUNT,
+};
+
+struct PathFindStats
+{
+	uint64_t search_count;
+	uint64_t expanded_node_count;
+	uint64_t cleared_byte_count; // Search state zeroed before or after searches, the memory traffic the pool avoids
+};
+
+enum PathFindQueue
+{
+	PATH_FIND_QUEUE_HEAP,   // GridNodeHeap
+	PATH_FIND_QUEUE_BUCKET, // GridNodeBuckets
+
+	PATH_FIND_QUEUE_COUNT,
+};
+
+// Open list ordering of the A* and JPS modes, each is its own template instance of the search loop
+enum PathFindPolicy
+{
+	PATH_FIND_POLICY_OPTIMAL,  // f = g + h, exact distances
+	PATH_FIND_POLICY_WEIGHTED, // f = g + weight * h, paths at most weight times longer than optimal
+	PATH_FIND_POLICY_GREEDY,   // f = h, best-first towards the target, no bound on the path length
+
+	PATH_FIND_POLICY_COUNT,
+};
+
+struct PathFindOptions
+{
+	PathFindMode   mode;
+	PathFindQueue  queue;         // Open list used by the A* and JPS modes
+	PathFindPolicy policy;        // A* and JPS modes only, the other modes are always exact
+	float          weight;        // PATH_FIND_POLICY_WEIGHTED only, clamped to [1, PATH_FIND_MAX_WEIGHT]
+	bool           bidirectional; // A* mode with the optimal policy only, searches from both ends. Multi-target queries run one search per target
+	int            landmark_count; // PATH_FIND_MODE_ALT only, clamped to [1, MAX_LANDMARK_COUNT], 0 picks DEFAULT_LANDMARK_COUNT
+	PathFindStats *stats;         // Optional, accumulated into
+};
+
+struct PathTile
+{
+	int x;
+	int y;
+};
+
+// Tile rectangle, x1 and y1 are exclusive like Station
+struct MapRect
+{
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+};
+
+// Where one shortest path runs, as the bounding boxes of up to PATH_FOOTPRINT_BOX_COUNT even stretches of it. A change
+// that leaves every box free leaves the path free, so the pair can only get closer. Boxes are exclusive like MapRect,
+// box_count is 0 when no path was traced.
+const int PATH_FOOTPRINT_BOX_COUNT = 8;
+
+struct PathFootprint
+{
+	uint8_t box_count;
+	uint8_t x0[PATH_FOOTPRINT_BOX_COUNT];
+	uint8_t y0[PATH_FOOTPRINT_BOX_COUNT];
+	uint8_t x1[PATH_FOOTPRINT_BOX_COUNT];
+	uint8_t y1[PATH_FOOTPRINT_BOX_COUNT];
+};
+
+// Waves path_find_bits_internal keeps to trace footprints from, targets farther out get none
+const int BITS_WAVE_CAPACITY = 1024;
+
+// HPA* splits the map into square clusters. Entrances are placed on runs of free tiles along each cluster border,
+// one in the middle of a short run or one at each end of a long run, and each gets a node on both sides.
+const int HPA_CLUSTER_SIZE               = 16;
+const int HPA_CLUSTER_COUNT_X            = MAP_W / HPA_CLUSTER_SIZE;
+const int HPA_CLUSTER_COUNT_Y            = MAP_H / HPA_CLUSTER_SIZE;
+const int HPA_CLUSTER_COUNT              = HPA_CLUSTER_COUNT_X * HPA_CLUSTER_COUNT_Y;
+const int HPA_LONG_ENTRANCE_RUN          = 6;
+const int HPA_MAX_BORDER_ENTRANCE_COUNT  = HPA_CLUSTER_SIZE / 2; // Alternating free and blocked tiles
+const int HPA_MAX_CLUSTER_NODE_COUNT     = 4 * HPA_MAX_BORDER_ENTRANCE_COUNT;
+const int HPA_NODE_COUNT                 = HPA_CLUSTER_COUNT * HPA_MAX_CLUSTER_NODE_COUNT;
+const uint16_t HPA_UNREACHABLE           = 0xFFFF;
+static_assert(MAP_W % HPA_CLUSTER_SIZE == 0 && MAP_H % HPA_CLUSTER_SIZE == 0);
+const int HPA_CLUSTER_WORD_COUNT         = (HPA_CLUSTER_COUNT + 63) / 64;
+
+// Opposite borders differ in the lowest bit
+enum HpaBorder
+{
+	HPA_BORDER_LEFT,
+	HPA_BORDER_RIGHT,
+	HPA_BORDER_TOP,
+	HPA_BORDER_BOTTOM,
+
+	HPA_BORDER_COUNT,
+};
+
+// Nodes are grouped by border in HpaBorder order and by entrance order within a border, so the node across
+// an entrance is found at the same entrance index on the neighbor's opposite border
+struct HpaCluster
+{
+	int node_count;
+	int border_node_starts[HPA_BORDER_COUNT];
+	int border_node_counts[HPA_BORDER_COUNT];
+
+	PathTile nodes[HPA_MAX_CLUSTER_NODE_COUNT];
+	uint8_t  node_borders[HPA_MAX_CLUSTER_NODE_COUNT];
+	uint16_t distances[HPA_MAX_CLUSTER_NODE_COUNT][HPA_MAX_CLUSTER_NODE_COUNT]; // Steps without leaving the cluster
+};
+
+// One bit per cluster
+struct HpaClusterSet
+{
+	uint64_t words[HPA_CLUSTER_WORD_COUNT];
+};
+
+struct HpaGraph
+{
+	HpaCluster clusters[HPA_CLUSTER_COUNT];
+};
+
+const int VISIBILITY_MAX_RECT_COUNT  = 64;
+const int VISIBILITY_MAX_NODE_COUNT  = 5 * VISIBILITY_MAX_RECT_COUNT;
+const int VISIBILITY_NODE_WORD_COUNT = (VISIBILITY_MAX_NODE_COUNT + 63) / 64;
+
+// Exact distances when every obstacle is one of a few rectangles. A shortest 4-connected path can be split into
+// monotone pieces that meet at tiles diagonally outside rectangle corners, so the nodes are the doors and those
+// corner tiles, with a Manhattan length edge wherever a monotone path joins two nodes. Rectangle i's door is
+// node i and its corners are nodes rect_count + 4 * i + corner. Doors are assumed to be free tiles.
+struct VisibilityGraph
+{
+	int      rect_count;
+	MapRect  rects[VISIBILITY_MAX_RECT_COUNT];
+	PathTile nodes[VISIBILITY_MAX_NODE_COUNT];
+	uint64_t valid_nodes[VISIBILITY_NODE_WORD_COUNT]; // Corners off the map or on blocked tiles are left out
+	uint64_t edges[VISIBILITY_MAX_NODE_COUNT][VISIBILITY_NODE_WORD_COUNT];
+
+	MapBits free_bits;
+};
+
+const int MAX_LANDMARK_COUNT     = 8;
+const int DEFAULT_LANDMARK_COUNT = 4;
+
+// Breadth first distances from a few landmark tiles. By the triangle inequality |d(L, t) - d(L, n)| <= d(n, t) for
+// every landmark L, which bounds the distance around stations where Manhattan distance cannot see them. Landmarks are
+// picked farthest first so they spread to the edges of the free space, where the bounds are tightest. Distances are
+// FoundPath::tile_count (0 = unreached) and the landmarks of a tile sit together so a bound reads one cache line.
+struct LandmarkFields
+{
+	int      landmark_count;
+	PathTile landmarks[MAX_LANDMARK_COUNT];
+	uint16_t distances[MAP_W * MAP_H][MAX_LANDMARK_COUNT];
+};
 
 struct GridNode
 {
@@ -17,12 +210,18 @@ struct GridNode
 	int g; // Distance from start to node
 	int h; // Best distance (ignoring occlusions) from node to target
 
+	uint32_t generation; // Fields below are only valid when this matches GridNodePool::generation
+
 	bool opened;
 	bool closed;
 
-	int heap_idx;
+	int heap_idx; // Slot in GridNodeHeap, or the f bucket in GridNodeBuckets
 
 	GridNode *parent;
+
+	// Intrusive links for GridNodeBuckets
+	GridNode *bucket_prev;
+	GridNode *bucket_next;
 };
 
 // Binary minimum heap
@@ -32,10 +231,85 @@ struct GridNodeHeap
 	GridNode **nodes;
 };
 
-struct PathTile
+// Dial's bucket queue, one intrusive list per f value. Moves cost 1 and the heuristic is consistent
+// so f never drops below the current minimum and push, decrease-key and pop-min are all O(1) amortized.
+// The weighted and greedy policies can push below the minimum, insertion lowers min_bucket for them.
+// Ties on f only lean towards low h, so a search that hits max_step_count can stop on another node than the heap.
+struct GridNodeBuckets
 {
-	int x;
-	int y;
+	int        node_count;
+	int        min_bucket;
+	int        max_bucket;
+	GridNode **buckets;
+};
+
+// Per-thread search state that lives across searches. Bumping the generation stamp invalidates
+// every node at once, nodes are reset lazily when a search first touches them, so nothing has
+// to be cleared up front. Bucket lists are left empty after each search.
+struct GridNodePool
+{
+	Arena arena;
+
+	uint32_t  generation;
+	GridNode *nodes;
+	GridNode *reverse_nodes; // Target side of a bidirectional search, stamped with the same generation
+
+	GridNode **heap_nodes[2];
+	GridNode **buckets[2];
+	uint32_t  *target_stamps; // JPS target tiles, marked with the current generation
+
+	// Compact A* state, about 5 bytes per tile plus the heap. A node's position is its index and its parent
+	// is a 2-bit direction, see COMPACT_STATE_*
+	uint8_t   compact_generation;
+	uint8_t  *compact_states;
+	uint16_t *compact_g;
+	uint16_t *compact_heap_slots;
+	uint64_t *compact_heap; // Entries are (f << 40) | (h << 16) | tile index, compared as plain integers
+
+	HpaGraph        *hpa_graph;        // Rebuilt in full by PATH_FIND_MODE_HPA queries on another map than hpa_graph_map
+	VisibilityGraph *visibility_graph; // For callers without a graph of their own, see visibility_graph_update
+	LandmarkFields  *landmark_fields;  // Rebuilt by PATH_FIND_MODE_ALT queries on another map or landmark count than last time
+
+	uint64_t *visibility_heap; // Open list of visibility_door_distances, every improvement pushes at most once per edge
+
+	// Tiles hpa_graph was last built from. The queries cannot tell what changed, so they compare the whole map
+	OccupancyMap *hpa_graph_map;
+	bool          is_hpa_graph_built;
+
+	// Same for landmark_fields, landmark_fields_count is PathFindOptions::landmark_count as it was asked for
+	OccupancyMap *landmark_fields_map;
+	int           landmark_fields_count;
+	bool          is_landmark_fields_built;
+
+	// Frontier rows of the bitset waves when footprints are asked for. Wave w is the rows from bits_wave_y0s[w] on,
+	// starting at row bits_wave_offsets[w] of bits_wave_rows and ending where wave w + 1 starts
+	uint64_t *bits_wave_rows;
+	int      *bits_wave_offsets;
+	uint8_t  *bits_wave_y0s;
+};
+
+// Compact node state byte: opened, closed, parent direction and a 4-bit generation stamp
+const uint8_t COMPACT_STATE_OPENED           = 1 << 0;
+const uint8_t COMPACT_STATE_CLOSED           = 1 << 1;
+const int     COMPACT_STATE_DIR_SHIFT        = 2;
+const int     COMPACT_STATE_GENERATION_SHIFT = 4;
+const uint8_t COMPACT_STATE_GENERATION_COUNT = 15;
+
+struct CompactHeap
+{
+	int       count;
+	uint64_t *entries;
+	uint16_t *slots;
+};
+
+// One source and its targets, see path_find_batch
+struct PathFindJob
+{
+	OccupancyMap *map;
+	PathTile      start;
+	PathTile     *targets;
+	int           target_count;
+	int          *tile_counts; // Receives FoundPath::tile_count for each target
 };
 
 struct FoundPath
@@ -50,8 +324,21 @@ struct FoundPaths
 	FoundPath *paths;
 };
 
-void grid_node_set_h(GridNode *node, int target_x, int target_y);
-int  grid_node_cmp  (GridNode *a, GridNode *b);
+void map_bits_from_occupancy(MapBits *bits, OccupancyMap *map);
+bool map_bits_test          (MapBits *bits, int x, int y);
+
+// Blocked tile tests and writes, the rectangle versions work on whole words. x1 and y1 are exclusive like MapRect
+bool occupancy_test      (OccupancyMap *map, int x, int y);
+bool occupancy_test_rect (OccupancyMap *map, int x0, int y0, int x1, int y1);
+void occupancy_write_rect(OccupancyMap *map, int x0, int y0, int x1, int y1, bool is_blocked);
+
+// Set bits are the top-left corners of every w x h rectangle that covers only free tiles
+void occupancy_get_free_positions(MapBits *positions, OccupancyMap *map, int w, int h);
+void map_bits_clear_rect         (MapBits *bits, int x0, int y0, int x1, int y1);
+bool map_bits_pick_position      (MapBits *bits, int x1, int y1, unsigned int rank, PathTile *position);
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL> void grid_node_set_h(GridNode *node, int target_x, int target_y, int weight = PATH_FIND_WEIGHT_ONE, LandmarkFields *landmarks = NULL);
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL> int  grid_node_cmp  (GridNode *a, GridNode *b);
 
 int get_parent_idx (int idx);
 int get_l_child_idx(int idx);
@@ -59,11 +346,78 @@ int get_r_child_idx(int idx);
 
 GridNodeHeap heap_make(Arena *arena);
 
-void heap_swap      (GridNodeHeap *heap, int a, int b);
-void heap_heapify_up(GridNodeHeap *heap, int idx);
-void heap_insert    (GridNodeHeap *heap, GridNode *node);
-void heap_remove_min(GridNodeHeap *heap);
+void heap_swap(GridNodeHeap *heap, int a, int b);
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL> void heap_heapify_up(GridNodeHeap *heap, int idx);
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL> void heap_insert    (GridNodeHeap *heap, GridNode *node);
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL> void heap_remove_min(GridNodeHeap *heap);
+
+GridNodeBuckets buckets_make(Arena *arena);
+
+GridNodePool *grid_node_pool_get();
+void          grid_node_pool_begin_search(GridNodePool *pool);
+GridNode     *grid_node_get              (GridNodePool *pool, int x, int y);
+GridNode     *grid_node_get              (GridNodePool *pool, GridNode *nodes, int x, int y);
+
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL> void buckets_insert(GridNodeBuckets *buckets, GridNode *node);
+template <PathFindPolicy policy = PATH_FIND_POLICY_OPTIMAL> void buckets_update(GridNodeBuckets *buckets, GridNode *node);
+
+void buckets_remove(GridNodeBuckets *buckets, GridNode *node);
+GridNode *buckets_get_min(GridNodeBuckets *buckets);
+
+// Tile-producing queries, options picks A*, JPS, compact A*, HPA* or ALT and the queue (other modes fall back to A*,
+// PATH_FIND_MODE_VISIBILITY included)
+FoundPaths path_find_targets(OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, Arena *arena, PathFindOptions *options = NULL);
+FoundPath  path_find_target (OccupancyMap *map, int start_x, int start_y, int target_x, int target_y, int max_step_count, Arena *arena, PathFindOptions *options = NULL);
+
+const char *path_find_mode_name  (PathFindMode   mode);
+const char *path_find_queue_name (PathFindQueue  queue);
+const char *path_find_policy_name(PathFindPolicy policy);
+
+void path_find_stats_add(PathFindStats *dst, PathFindStats *src);
+
+// Distance-only queries, tile_counts/distances receive FoundPath::tile_count for each target without building any tiles.
+// distances is a door_count * door_count row-major matrix, filled from the lower-indexed door of each pair and mirrored.
+// The flood modes treat max_step_count as a depth limit, targets beyond it report 0.
+// The multi-source mode fills the whole matrix in one sweep, the lockstep mode runs the map as a single lane (single-source
+// queries of either run as PATH_FIND_MODE_BITS). PATH_FIND_MODE_VISIBILITY needs the station rectangles the map does not
+// keep and runs as PATH_FIND_MODE_A_STAR, callers with the rectangles use visibility_door_distances.
+// footprints can be NULL, else it gets the PathFootprint of each reached target laid out like tile_counts, or the upper
+// triangle of distances. Only the single-source flood and bitset searches trace paths, other modes leave it as it is.
+void path_find_target_distances(OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, int *tile_counts, PathFindOptions *options = NULL, PathFootprint *footprints = NULL);
+void path_find_door_distances  (OccupancyMap *map, PathTile *doors, int door_count, int max_step_count, int *distances, PathFindOptions *options = NULL, PathFootprint *footprints = NULL);
+
+bool path_footprint_test_rect(PathFootprint *footprint, int x0, int y0, int x1, int y1);
+
+// Door matrices for up to MAX_LOCKSTEP_LANE_COUNT maps in one sweep per door index. Lane i reads maps[i] and doors[i]
+// and fills distances[i] the same as path_find_door_distances with PATH_FIND_MODE_BITS. The row words of all lanes
+// are interleaved so every wave step is one loop over lanes the compiler can vectorize. Lanes run until the slowest
+// lane is done, so maps with similar door counts should share a sweep. Single maps run as one lane.
+void path_find_lockstep_door_distances(OccupancyMap **maps, PathTile **doors, int *door_counts, int lane_count, int max_step_count, int **distances, PathFindStats *stats = NULL);
+
+// Distance-only queries for many jobs in one call, the same results as path_find_target_distances on each job.
+// Consecutive jobs on the same map share the per-map setup (the bitset map, the HPA* graph, the landmarks), so group jobs by map
+// and leave the maps unchanged until the call returns. The multi-source and lockstep modes run each job as PATH_FIND_MODE_BITS,
+// PATH_FIND_MODE_VISIBILITY as PATH_FIND_MODE_A_STAR.
+void path_find_batch(PathFindJob *jobs, int job_count, int max_step_count, PathFindOptions *options = NULL);
+
+// HPA* with caller-owned graphs. Accumulate hpa_add_touched_clusters for every map write (see Factory::dirty_clusters)
+// and pass the set to hpa_graph_update, only those clusters are rebuilt. A new graph needs a NULL set, every cluster.
+void       hpa_add_touched_clusters(HpaClusterSet *clusters, int x0, int y0, int x1, int y1);
+void       hpa_graph_update        (HpaGraph *graph, OccupancyMap *map, HpaClusterSet *dirty_clusters, PathFindStats *stats = NULL);
+FoundPath  hpa_path_find_target    (HpaGraph *graph, OccupancyMap *map, int start_x, int start_y, int target_x, int target_y, int max_step_count, Arena *arena, PathFindStats *stats = NULL);
+FoundPaths hpa_path_find_targets   (HpaGraph *graph, OccupancyMap *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, Arena *arena, PathFindStats *stats = NULL);
+void       hpa_door_distances      (HpaGraph *graph, OccupancyMap *map, PathTile *doors, int door_count, int max_step_count, int *distances, PathFindStats *stats = NULL);
+
+// Landmark selection and distance fields for PATH_FIND_MODE_ALT, one full breadth first flood per landmark plus one to
+// find the first landmark. Searches through path_find_* build their own once per map, this is for callers that keep
+// fields per map.
+void landmark_fields_build    (LandmarkFields *fields, OccupancyMap *map, int landmark_count, PathFindStats *stats = NULL);
+int  landmark_fields_get_bound(LandmarkFields *fields, int x, int y, int target_x, int target_y);
 
-FoundPaths path_find_targets(MapTile *map, int start_x, int start_y, PathTile *targets, int target_count, int max_step_count, Arena *arena);
-FoundPath  path_find_target (MapTile *map, int start_x, int start_y, int target_x, int target_y, int max_step_count, Arena *arena);
+// Brings the graph in line with the given rectangles and doors (the map must already match them). Only rectangles
+// that differ from the last update are re-tested, so a mutated factory or a crossover child updated from one of
+// its parents' graphs is cheaper than a first build. visibility_door_distances matches PATH_FIND_MODE_FLOOD.
+void visibility_graph_update   (VisibilityGraph *graph, OccupancyMap *map, MapRect *rects, PathTile *doors, int rect_count, PathFindStats *stats = NULL);
+void visibility_door_distances (VisibilityGraph *graph, int max_step_count, int *distances, PathFindStats *stats = NULL);
 
@@ -38,6 +38,7 @@ enum KeyMap
 	KEY_CONTROL = VK_CONTROL,
 	KEY_MENU    = VK_MENU,
 	KEY_RETURN  = VK_RETURN,
+	KEY_TAB     = VK_TAB,
 	KEY_SHIFT   = VK_SHIFT,
 	KEY_DELETE  = VK_DELETE,
 
@@ -67,6 +68,8 @@ struct InputState
 	uint64_t elapsed_microsecs;
 };
 
+uint64_t time_get_microsecs();
+
 uint64_t  vmem_page_size();
 void     *vmem_reserve  (uint64_t size);
 bool      vmem_commit   (void *base, uint64_t size);
@@ -1,4 +1,5 @@
 #include <windows.h>
+#include <intrin.h>
 
 #include <gl/gl.h>
 
@@ -92,6 +93,24 @@ DWORD WINAPI thread_proc(LPVOID param)
 	return 0;
 }
 
+uint64_t time_get_microsecs()
+{
+	static LARGE_INTEGER frequency = {};
+	if(!frequency.QuadPart)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+
+	LARGE_INTEGER count;
+	QueryPerformanceCounter(&count);
+
+	// Split to avoid overflowing the multiply on long uptimes
+	uint64_t seconds   = count.QuadPart / frequency.QuadPart;
+	uint64_t remainder = count.QuadPart % frequency.QuadPart;
+
+	uint64_t result = seconds * 1000000 + (remainder * 1000000) / frequency.QuadPart;
+	return result;
+}
 
 uint64_t vmem_page_size()
 {
@@ -271,7 +290,7 @@ int WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line, int sho
 	Arena permanent_arena = arena_make();
 	Arena transient_arena = arena_make();
 
-	AppState app = app_make("c:/windows/fonts/arial.ttf", rng_seed, &permanent_arena);
+	AppState app = app_make("c:/windows/fonts/arial.ttf", rng_seed, &work_queue, &permanent_arena);
 
 	LARGE_INTEGER frequency;
 	QueryPerformanceFrequency(&frequency);